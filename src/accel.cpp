@@ -0,0 +1,358 @@
+#include "accel.hpp"
+
+#define TINYBVH_IMPLEMENTATION
+
+#include <algorithm>
+#include <cassert>
+#include <tiny_bvh.h>
+
+/// @brief Max number of primitives in an analytic BVH leaf.
+static constexpr uint32_t AnalyticLeafSize = 2;
+
+/// @brief Analytic BVH traversal stack size, median splits keep the tree depth at log2 of the primitive count.
+static constexpr uint32_t AnalyticStackSize = 64;
+
+/// @brief Intersect a ray with a box before the current ray hit (slab test).
+/// @param ray
+/// @param aabbMin
+/// @param aabbMax
+/// @return Entry distance, BVH_FAR if the box is missed.
+static float intersectBounds(tinybvh::Ray const& ray, glm::vec3 const& aabbMin, glm::vec3 const& aabbMax)
+{
+	float const tx0 = (aabbMin.x - ray.O.x) * ray.rD.x, tx1 = (aabbMax.x - ray.O.x) * ray.rD.x;
+	float const ty0 = (aabbMin.y - ray.O.y) * ray.rD.y, ty1 = (aabbMax.y - ray.O.y) * ray.rD.y;
+	float const tz0 = (aabbMin.z - ray.O.z) * ray.rD.z, tz1 = (aabbMax.z - ray.O.z) * ray.rD.z;
+
+	float const tEnter = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0F));
+	float const tExit = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), ray.hit.t));
+	return (tEnter <= tExit) ? tEnter : BVH_FAR;
+}
+
+void AccelerationStructure::build(Scene const& scene)
+{
+	assert(!scene.materials.empty());
+	assert(!scene.meshes.empty() || !scene.primitives.empty());
+
+	// Set scene
+	m_pScene = &scene;
+
+	// Generate render instances
+	m_instances.clear();
+	for (auto const& object : scene.objects) {
+		m_instances.push_back(RenderInstance{ object.mesh, object.material });
+	}
+
+	// Create BLASses for meshes in scene
+	m_blasses.clear();
+	m_blasses.reserve(scene.meshes.size());
+	for (auto const& mesh : scene.meshes)
+	{
+		tinybvh::bvhvec4slice vertices{};
+		vertices.data = reinterpret_cast<int8_t const*>(mesh.vertices.data());
+		vertices.stride = sizeof(Vertex);
+		vertices.count = static_cast<uint32_t>(mesh.vertices.size());
+
+		std::shared_ptr<tinybvh::BVH> blas = std::make_shared<tinybvh::BVH>();
+		blas->PrepareBuild(vertices, mesh.indices.data(), mesh.indices.size() / 3);
+		m_blasses.push_back(blas);
+	}
+
+	// Build all BLASses & store pointers for TLAS build
+	m_blasPointers.clear();
+	m_blasPointers.reserve(m_blasses.size());
+	for (auto const& blas : m_blasses)
+	{
+		blas->Build();
+		m_blasPointers.push_back(blas.get());
+	}
+
+	// Build TLAS using instances (just straight up using meshes at world origin for now)
+	m_blasInstances.clear();
+	m_blasInstances.reserve(m_instances.size());
+	for (auto const& instance : m_instances)
+	{
+		assert(instance.object < m_blasses.size());
+		tinybvh::BLASInstance blas(static_cast<uint32_t>(instance.object));
+		blas.aabbMin = m_blasses[instance.object]->aabbMin;
+		blas.aabbMax = m_blasses[instance.object]->aabbMax;
+
+		m_blasInstances.push_back(blas);
+	}
+
+	m_tlas.reset();
+	if (!m_blasInstances.empty())
+	{
+		m_tlas = std::make_unique<tinybvh::BVH>();
+		m_tlas->Build(m_blasInstances.data(), static_cast<uint32_t>(m_blasInstances.size()), m_blasPointers.data(), static_cast<uint32_t>(m_blasPointers.size()));
+	}
+
+	// Build a separate BVH over the analytic primitives, intersected in closed form during traversal
+	uint32_t const primitiveCount = static_cast<uint32_t>(scene.primitives.size());
+	m_analyticIndices.resize(primitiveCount);
+	for (uint32_t i = 0; i < primitiveCount; i++) {
+		m_analyticIndices[i] = i;
+	}
+
+	m_analyticNodes.clear();
+	if (primitiveCount > 0)
+	{
+		m_analyticNodes.reserve(2 * primitiveCount - 1);
+		m_analyticNodes.push_back(AnalyticNode{});
+		buildAnalyticNode(0, 0, primitiveCount);
+	}
+}
+
+void AccelerationStructure::buildAnalyticNode(uint32_t node, uint32_t first, uint32_t count)
+{
+	// Fit node to primitive bounds
+	glm::vec3 aabbMin(BVH_FAR), aabbMax(-BVH_FAR);
+	glm::vec3 centroidMin(BVH_FAR), centroidMax(-BVH_FAR);
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		glm::vec3 min{}, max{};
+		m_pScene->primitives[m_analyticIndices[i]].bounds(min, max);
+		aabbMin = glm::min(aabbMin, min);
+		aabbMax = glm::max(aabbMax, max);
+		centroidMin = glm::min(centroidMin, 0.5F * (min + max));
+		centroidMax = glm::max(centroidMax, 0.5F * (min + max));
+	}
+
+	m_analyticNodes[node].aabbMin = aabbMin;
+	m_analyticNodes[node].aabbMax = aabbMax;
+	if (count <= AnalyticLeafSize)
+	{
+		m_analyticNodes[node].first = first;
+		m_analyticNodes[node].count = count;
+		return;
+	}
+
+	// Split at the median primitive along the largest centroid axis
+	glm::vec3 const extent = centroidMax - centroidMin;
+	int const axis = (extent.x > extent.y) ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	auto const centroid = [&](uint32_t primitive) {
+		glm::vec3 min{}, max{};
+		m_pScene->primitives[primitive].bounds(min, max);
+		return min[axis] + max[axis];
+	};
+
+	uint32_t const leftCount = count / 2;
+	std::nth_element(
+		m_analyticIndices.begin() + first,
+		m_analyticIndices.begin() + first + leftCount,
+		m_analyticIndices.begin() + first + count,
+		[&](uint32_t a, uint32_t b) { return centroid(a) < centroid(b); }
+	);
+
+	uint32_t const left = static_cast<uint32_t>(m_analyticNodes.size());
+	m_analyticNodes.push_back(AnalyticNode{});
+	m_analyticNodes.push_back(AnalyticNode{});
+	m_analyticNodes[node].first = left;
+	m_analyticNodes[node].count = 0;
+
+	buildAnalyticNode(left, first, leftCount);
+	buildAnalyticNode(left + 1, first + leftCount, count - leftCount);
+}
+
+bool AccelerationStructure::intersectAnalytic(tinybvh::Ray& ray, bool anyHit) const
+{
+	if (m_analyticNodes.empty()) {
+		return false;
+	}
+
+	glm::vec3 const origin = glm::vec3(ray.O.x, ray.O.y, ray.O.z);
+	glm::vec3 const direction = glm::vec3(ray.D.x, ray.D.y, ray.D.z);
+
+	// Children are culled before being visited near to far, so closer hits shrink the ray early.
+	// The root is not culled, rays reaching this point mostly start inside the scene bounds.
+	uint32_t stack[AnalyticStackSize];
+	uint32_t stackSize = 0;
+	AnalyticNode const* pNode = &m_analyticNodes[0];
+
+	bool isHit = false;
+	while (true)
+	{
+		if (pNode->count > 0)
+		{
+			for (uint32_t i = pNode->first; i < pNode->first + pNode->count; i++)
+			{
+				float t = 0.0F;
+				glm::vec2 uv{};
+				uint32_t const primitive = m_analyticIndices[i];
+				if (!m_pScene->primitives[primitive].intersect(origin, direction, ray.hit.t, t, uv)) {
+					continue;
+				}
+
+				if (anyHit) {
+					return true;
+				}
+
+				ray.hit.t = t;
+				ray.hit.u = uv.x;
+				ray.hit.v = uv.y;
+				ray.hit.prim = primitive;
+				ray.hit.inst = AnalyticInstance;
+				isHit = true;
+			}
+
+			if (stackSize == 0) {
+				break;
+			}
+
+			pNode = &m_analyticNodes[stack[--stackSize]];
+			continue;
+		}
+
+		uint32_t near = pNode->first;
+		uint32_t far = pNode->first + 1;
+		float tNear = intersectBounds(ray, m_analyticNodes[near].aabbMin, m_analyticNodes[near].aabbMax);
+		float tFar = intersectBounds(ray, m_analyticNodes[far].aabbMin, m_analyticNodes[far].aabbMax);
+		if (tNear > tFar)
+		{
+			std::swap(near, far);
+			std::swap(tNear, tFar);
+		}
+
+		if (tNear >= BVH_FAR)
+		{
+			if (stackSize == 0) {
+				break;
+			}
+
+			pNode = &m_analyticNodes[stack[--stackSize]];
+			continue;
+		}
+
+		if (tFar < BVH_FAR)
+		{
+			assert(stackSize < AnalyticStackSize);
+			stack[stackSize++] = far;
+		}
+
+		pNode = &m_analyticNodes[near];
+	}
+
+	return isHit;
+}
+
+bool AccelerationStructure::intersect(tinybvh::Ray& ray) const
+{
+	if (m_tlas != nullptr) {
+		m_tlas->Intersect(ray);
+	}
+
+	intersectAnalytic(ray, false);
+	return ray.hit.t < BVH_FAR;
+}
+
+void AccelerationStructure::intersect(tinybvh::Ray* rays, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (m_tlas != nullptr) {
+			m_tlas->Intersect(rays[i]);
+		}
+
+		intersectAnalytic(rays[i], false);
+	}
+}
+
+bool AccelerationStructure::isOccluded(tinybvh::Ray const& ray) const
+{
+	if (m_tlas != nullptr && m_tlas->IsOccluded(ray)) {
+		return true;
+	}
+
+	tinybvh::Ray shadowRay = ray;
+	return intersectAnalytic(shadowRay, true);
+}
+
+size_t AccelerationStructure::memoryUsage() const
+{
+	size_t size = 0;
+	for (auto const& blas : m_blasses) {
+		size += blas->usedNodes * sizeof(tinybvh::BVH::BVHNode) + blas->idxCount * sizeof(uint32_t);
+	}
+
+	if (m_tlas != nullptr) {
+		size += m_tlas->usedNodes * sizeof(tinybvh::BVH::BVHNode) + m_tlas->idxCount * sizeof(uint32_t);
+	}
+
+	size += m_analyticNodes.size() * sizeof(AnalyticNode) + m_analyticIndices.size() * sizeof(uint32_t);
+	return size + m_blasInstances.size() * sizeof(tinybvh::BLASInstance);
+}
+
+size_t AccelerationStructure::geometryMemoryUsage() const
+{
+	size_t size = 0;
+	for (auto const& mesh : m_pScene->meshes) {
+		size += mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(uint32_t);
+	}
+
+	return size + m_pScene->primitives.size() * sizeof(AnalyticPrimitive);
+}
+
+SurfaceInteraction AccelerationStructure::getSurfaceInteraction(tinybvh::Ray const& ray) const
+{
+	// Get ray direction
+	glm::vec3 const rayDirection = glm::vec3(ray.D.x, ray.D.y, ray.D.z);
+
+	// Analytic hits evaluate the surface from the hit distance
+	if (ray.hit.inst == AnalyticInstance)
+	{
+		AnalyticPrimitive const& shape = m_pScene->primitives[ray.hit.prim];
+		glm::vec3 const position = glm::vec3(ray.O.x, ray.O.y, ray.O.z) + ray.hit.t * rayDirection;
+		glm::vec3 const normal = shape.normalAt(position);
+		glm::vec3 const tangent = shape.tangentAt(position);
+
+		bool const isBackfaceHit = glm::dot(rayDirection, normal) > 0.0F;
+		glm::vec3 const N = (isBackfaceHit ? -normal : normal);
+		glm::vec3 const T = (isBackfaceHit ? -tangent : tangent);
+		glm::vec3 const B = glm::normalize(glm::cross(N, T));
+
+		return SurfaceInteraction{
+			position,
+			N,
+			glm::mat3(T, B, N),
+			&m_pScene->materials[shape.material],
+			AnalyticInstance,
+			ray.hit.prim,
+			isBackfaceHit,
+			true,
+		};
+	}
+
+	// Get hit geometry & material from scene
+	RenderInstance const& instance	= m_instances[ray.hit.inst];
+	Mesh const& mesh				= m_pScene->meshes[instance.object];
+	Material const& material		= m_pScene->materials[instance.material];
+
+	// Get hit triangle from mesh
+	uint32_t const& idx = mesh.indices[ray.hit.prim * 3];
+	Vertex const& v0 = mesh.vertices[idx + 0];
+	Vertex const& v1 = mesh.vertices[idx + 1];
+	Vertex const& v2 = mesh.vertices[idx + 2];
+
+	// Interpolate triangle data according to hit UV, u & v weigh the second & third vertex
+	glm::vec3 const barycentric	= { 1.0F - ray.hit.u - ray.hit.v, ray.hit.u, ray.hit.v };
+	glm::vec3 const position	= barycentric.x * v0.position + barycentric.y * v1.position + barycentric.z * v2.position;
+	glm::vec3 const normal		= glm::normalize(barycentric.x * v0.normal + barycentric.y * v1.normal + barycentric.z * v2.normal);
+	glm::vec3 const tangent		= glm::normalize(barycentric.x * v0.tangent + barycentric.y * v1.tangent + barycentric.z * v2.tangent);
+
+	// Set up TBN matrix for global/local frame conversion (also adjusts normal and tangent for backface hits)
+	bool const isBackfaceHit = glm::dot(rayDirection, normal) > 0.0F;
+	glm::vec3 const N = (isBackfaceHit ? -normal : normal);
+	glm::vec3 const _T = (isBackfaceHit ? -tangent : tangent);
+	glm::vec3 const T = glm::normalize(_T - glm::dot(_T, N) * N);
+	glm::vec3 const B = glm::normalize(glm::cross(N, T));
+
+	return SurfaceInteraction{
+		position,
+		N,
+		glm::mat3(T, B, N),
+		&material,
+		ray.hit.inst,
+		ray.hit.prim,
+		isBackfaceHit,
+		false,
+	};
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <tiny_bvh.h>
+
+#include "material.hpp"
+#include "primitive.hpp"
+#include "scene.hpp"
+
+/// @brief Surface data for a ray hit, shading frame is oriented towards the incoming ray.
+struct SurfaceInteraction
+{
+	glm::vec3		position;
+	glm::vec3		normal;
+	glm::mat3		TBN;
+	Material const*	material;
+	uint32_t		instance;		//< render instance index for mesh hits, AccelerationStructure::AnalyticInstance for analytic hits
+	uint32_t		primitive;		//< triangle index for mesh hits, scene primitive index for analytic hits
+	bool			isBackfaceHit;
+	bool			isAnalytic;		//< hit an analytic primitive instead of a mesh triangle
+};
+
+/// @brief The AccelerationStructure builds & traverses the BLAS/TLAS hierarchy for a scene.
+/// Analytic primitives are kept in a separate BVH, traversed after the TLAS with the closest mesh hit as max distance.
+class AccelerationStructure
+{
+public:
+	/// @brief Instance index stored in ray hits & surface interactions of analytic primitive hits.
+	static constexpr uint32_t AnalyticInstance = ~0U;
+
+	/// @brief Build acceleration structures for a scene, the scene must outlive the acceleration structure.
+	/// @param scene
+	void build(Scene const& scene);
+
+	/// @brief Find the closest hit along a ray.
+	/// @param ray Ray to intersect, hit data is stored in the ray.
+	/// @return true if the ray hit scene geometry.
+	bool intersect(tinybvh::Ray& ray) const;
+
+	/// @brief Find the closest hits for an array of rays.
+	/// @param rays Rays to intersect, hit data is stored in the rays.
+	/// @param count 
+	void intersect(tinybvh::Ray* rays, size_t count) const;
+
+	/// @brief Check if a ray is occluded before its max distance.
+	/// @param ray
+	/// @return
+	bool isOccluded(tinybvh::Ray const& ray) const;
+
+	/// @brief Get the surface interaction for a ray that hit scene geometry.
+	/// @param ray
+	/// @return
+	SurfaceInteraction getSurfaceInteraction(tinybvh::Ray const& ray) const;
+
+	/// @brief Check if acceleration structures have been built.
+	/// @return
+	bool isBuilt() const { return m_pScene != nullptr && (m_tlas != nullptr || !m_analyticNodes.empty()); }
+
+	/// @brief Get the scene used to build the acceleration structures.
+	/// @return
+	Scene const* getScene() const { return m_pScene; }
+
+	/// @brief Get the size in bytes of the BVH nodes & primitive indices of all acceleration structures.
+	/// @return
+	size_t memoryUsage() const;
+
+	/// @brief Get the size in bytes of the geometry referenced by the acceleration structures.
+	/// @return
+	size_t geometryMemoryUsage() const;
+
+private:
+	struct RenderInstance
+	{
+		uint32_t	object;		//< BLAS index, equal to the scene mesh index
+		uint32_t	material;	//< scene material index
+	};
+
+	/// @brief Analytic BVH node, leaves reference count primitives starting at first, interior nodes have
+	/// their children at first & first + 1.
+	struct AnalyticNode
+	{
+		glm::vec3	aabbMin;
+		uint32_t	first;
+		glm::vec3	aabbMax;
+		uint32_t	count;		//< 0 for interior nodes
+	};
+
+private:
+	/// @brief Fit an analytic BVH node to a range of primitive indices & split it until leaves are small enough.
+	/// @param node
+	/// @param first
+	/// @param count
+	void buildAnalyticNode(uint32_t node, uint32_t first, uint32_t count);
+
+	/// @brief Traverse the analytic BVH, closer hits are stored in the ray.
+	/// @param ray
+	/// @param anyHit Stop at the first hit before the ray max distance, used for occlusion queries.
+	/// @return true if an analytic primitive was hit.
+	bool intersectAnalytic(tinybvh::Ray& ray, bool anyHit) const;
+
+private:
+	Scene const*								m_pScene			= nullptr;
+
+	// -- Scene Data --
+	std::vector<RenderInstance>					m_instances			= {};
+
+	// -- Acceleration Structures --
+	std::vector<std::shared_ptr<tinybvh::BVH>>	m_blasses			= {};
+	std::vector<tinybvh::BVHBase*>				m_blasPointers		= {}; //< required for tinybvh blas instancing :/
+	std::vector<tinybvh::BLASInstance>			m_blasInstances		= {};
+	std::shared_ptr<tinybvh::BVH>				m_tlas				= {}; //< null if the scene has no meshes
+	std::vector<AnalyticNode>					m_analyticNodes		= {}; //< empty if the scene has no analytic primitives
+	std::vector<uint32_t>						m_analyticIndices	= {}; //< scene primitive indices, referenced by analytic leaves
+};
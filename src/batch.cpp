@@ -0,0 +1,77 @@
+#include "batch.hpp"
+
+#include <cassert>
+
+/// @brief Convert renderer rays to tinybvh rays.
+/// @param rays
+/// @param maxDistances Per ray max distance, nullptr for unbounded rays.
+/// @param count
+/// @param output
+static void convertRays(Ray const* rays, float const* maxDistances, size_t count, tinybvh::Ray* output)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		Ray const& ray = rays[i];
+		float const tMax = (maxDistances != nullptr) ? maxDistances[i] : BVH_FAR;
+		output[i] = tinybvh::Ray({ ray.O.x, ray.O.y, ray.O.z }, { ray.D.x, ray.D.y, ray.D.z }, tMax);
+	}
+}
+
+BatchTracer::BatchTracer(Integrator const& integrator)
+	:
+	m_pIntegrator(&integrator),
+	m_pAccel(&integrator.getAccelerationStructure())
+{
+	assert(m_pAccel->isBuilt() && "Batch tracer needs integrator scene data to be set");
+}
+
+void BatchTracer::intersect(Ray const* rays, size_t count, HitRecord* hits) const
+{
+	tinybvh::Ray chunk[ChunkSize];
+	for (size_t first = 0; first < count; first += ChunkSize)
+	{
+		size_t const chunkCount = glm::min(ChunkSize, count - first);
+		convertRays(rays + first, nullptr, chunkCount, chunk);
+
+		m_pAccel->intersect(chunk, chunkCount);
+		for (size_t i = 0; i < chunkCount; i++)
+		{
+			tinybvh::Ray const& ray = chunk[i];
+			bool const isHit = ray.hit.t < BVH_FAR;
+			hits[first + i] = HitRecord{
+				isHit ? ray.hit.t : INFINITY,
+				glm::vec2(ray.hit.u, ray.hit.v),
+				ray.hit.inst,
+				ray.hit.prim,
+				isHit && ray.hit.inst == AccelerationStructure::AnalyticInstance,
+			};
+		}
+	}
+}
+
+void BatchTracer::occluded(Ray const* rays, float const* maxDistances, size_t count, uint32_t* occlusionBits) const
+{
+	for (size_t word = 0; word < (count + 31) / 32; word++) {
+		occlusionBits[word] = 0;
+	}
+
+	tinybvh::Ray chunk[ChunkSize];
+	for (size_t first = 0; first < count; first += ChunkSize)
+	{
+		size_t const chunkCount = glm::min(ChunkSize, count - first);
+		convertRays(rays + first, (maxDistances != nullptr) ? maxDistances + first : nullptr, chunkCount, chunk);
+
+		for (size_t i = 0; i < chunkCount; i++)
+		{
+			size_t const index = first + i;
+			if (m_pAccel->isOccluded(chunk[i])) {
+				occlusionBits[index / 32] |= 1U << (index % 32);
+			}
+		}
+	}
+}
+
+void BatchTracer::radiance(Ray const* rays, size_t count, Sampler& sampler, TraceContext const& context, glm::vec3* radiance) const
+{
+	m_pIntegrator->traceBatch(rays, count, sampler, context, radiance);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "integrator.hpp"
+#include "ray.hpp"
+#include "sampler.hpp"
+
+/// @brief Closest hit record for a ray in a batch.
+struct HitRecord
+{
+	float		t;			//< hit distance, infinity if the ray missed
+	glm::vec2	uv;			//< barycentric coordinates of mesh hits, u & v weigh the second & third triangle vertex, surface parameterization of analytic hits
+	uint32_t	instance;	//< scene object index of mesh hits, unused for analytic hits
+	uint32_t	primitive;	//< triangle index in the object mesh, scene primitive index for analytic hits
+	bool		isAnalytic;	//< hit an analytic primitive instead of a mesh triangle
+
+	bool isHit() const { return t < INFINITY; }
+};
+
+/// @brief The BatchTracer answers queries for arrays of rays against the acceleration structures of an integrator.
+/// This is a convenience API: rays are converted in fixed size chunks but still traversed one at a time, without
+/// packet traversal or ray reordering, so throughput matches single ray queries. The integrator TLAS is reused.
+class BatchTracer
+{
+public:
+	/// @brief Create a batch tracer, the integrator must have scene data set & outlive the batch tracer.
+	/// @param integrator
+	BatchTracer(Integrator const& integrator);
+
+	/// @brief Find the closest hits for a batch of rays.
+	/// @param rays
+	/// @param count
+	/// @param hits Output array of count hit records.
+	void intersect(Ray const* rays, size_t count, HitRecord* hits) const;
+
+	/// @brief Check occlusion for a batch of rays.
+	/// @param rays
+	/// @param maxDistances Per ray occlusion distance, nullptr to test up to infinity.
+	/// @param count
+	/// @param occlusionBits Output array of (count + 31) / 32 words, bit i is set if ray i is occluded.
+	void occluded(Ray const* rays, float const* maxDistances, size_t count, uint32_t* occlusionBits) const;
+
+	/// @brief Estimate radiance for a batch of rays using the integrator.
+	/// @param rays
+	/// @param count
+	/// @param sampler Sampler to use for random sampling during integration.
+	/// @param context Render state shared by all rays in the batch.
+	/// @param radiance Output array of count radiance estimates.
+	void radiance(Ray const* rays, size_t count, Sampler& sampler, TraceContext const& context, glm::vec3* radiance) const;
+
+public:
+	/// @brief Number of rays converted & traversed together.
+	static constexpr size_t ChunkSize = 64;
+
+private:
+	Integrator const*				m_pIntegrator	= nullptr;
+	AccelerationStructure const*	m_pAccel		= nullptr;
+};
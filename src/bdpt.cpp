@@ -0,0 +1,579 @@
+#include "bdpt.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "brdf.hpp"
+
+static constexpr float PI		= 3.14159265358979F;
+static constexpr float INV_2PI	= 1.0F / (2.0F * PI);
+static constexpr float RAY_EPSILON = 1e-3F;
+
+/// @brief Create an orthonormal basis around a normal (Building an Orthonormal Basis, Revisited, Duff et al.)
+/// @param n
+/// @return A TBN matrix with n as its Z axis.
+static glm::mat3 createBasis(glm::vec3 const& n)
+{
+	float const sign = n.z >= 0.0F ? 1.0F : -1.0F;
+	float const a = -1.0F / (sign + n.z);
+	float const b = n.x * n.y * a;
+	glm::vec3 const T(1.0F + sign * n.x * n.x * a, sign * b, -sign * n.x);
+	glm::vec3 const B(b, sign + n.y * n.y * a, -n.y);
+
+	return glm::mat3(T, B, n);
+}
+
+/// @brief Check if a color is black.
+/// @param color
+/// @return
+static bool isBlack(glm::vec3 const& color)
+{
+	return color.x == 0.0F && color.y == 0.0F && color.z == 0.0F;
+}
+
+/// @brief Remap zero densities to one, used for MIS ratios of unsampleable vertices.
+/// @param value
+/// @return
+static float remap0(float value)
+{
+	return value != 0.0F ? value : 1.0F;
+}
+
+BidirectionalIntegrator::BidirectionalIntegrator(uint32_t maxBounceDepth)
+	:
+	m_maxBounceDepth(glm::min(maxBounceDepth, MaxBounceDepth))
+{
+	//
+}
+
+void BidirectionalIntegrator::setSceneData(Scene const& scene)
+{
+	// Set scene & build acceleration structures
+	m_pScene = &scene;
+	m_accel.build(scene);
+
+	// Gather emissive triangles, mesh instances map 1:1 to scene objects
+	m_lights.clear();
+	m_instanceLightOffsets.clear();
+	m_primitiveLights.clear();
+	for (auto const& object : scene.objects)
+	{
+		Material const& material = scene.materials[object.material];
+		if (isBlack(material.emission))
+		{
+			m_instanceLightOffsets.push_back(NoLight);
+			continue;
+		}
+
+		m_instanceLightOffsets.push_back(static_cast<uint32_t>(m_lights.size()));
+		Mesh const& mesh = scene.meshes[object.mesh];
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			glm::vec3 const& p0 = mesh.vertices[mesh.indices[i + 0]].position;
+			glm::vec3 const& p1 = mesh.vertices[mesh.indices[i + 1]].position;
+			glm::vec3 const& p2 = mesh.vertices[mesh.indices[i + 2]].position;
+			glm::vec3 const cross = glm::cross(p1 - p0, p2 - p0);
+			float const crossLength = glm::length(cross);
+
+			// Degenerate triangles are kept to preserve primitive indexing, they are never sampled
+			Emitter light{};
+			light.p0 = p0;
+			light.p1 = p1;
+			light.p2 = p2;
+			light.normal = crossLength > 0.0F ? cross / crossLength : glm::vec3(0.0F, 1.0F, 0.0F);
+			light.emission = material.emission;
+			light.area = 0.5F * crossLength;
+			light.primitive = NoLight;
+			m_lights.push_back(light);
+		}
+	}
+
+	// Gather emissive analytic primitives
+	for (size_t i = 0; i < scene.primitives.size(); i++)
+	{
+		AnalyticPrimitive const& primitive = scene.primitives[i];
+		Material const& material = scene.materials[primitive.material];
+		if (isBlack(material.emission))
+		{
+			m_primitiveLights.push_back(NoLight);
+			continue;
+		}
+
+		m_primitiveLights.push_back(static_cast<uint32_t>(m_lights.size()));
+		Emitter light{};
+		light.normal = primitive.normal;
+		light.emission = material.emission;
+		light.area = primitive.area();
+		light.primitive = static_cast<uint32_t>(i);
+		m_lights.push_back(light);
+	}
+
+	// Build light selection distribution proportional to emitted power
+	m_lightPDFs.resize(m_lights.size());
+	m_lightCDF.resize(m_lights.size() + 1);
+	m_lightCDF[0] = 0.0F;
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		m_lightPDFs[i] = glm::max(luma(m_lights[i].emission), 0.0F) * m_lights[i].area;
+		m_lightCDF[i + 1] = m_lightCDF[i] + m_lightPDFs[i];
+	}
+
+	float const totalPower = m_lightCDF.back();
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		m_lightPDFs[i] = (totalPower > 0.0F) ? m_lightPDFs[i] / totalPower : 0.0F;
+		m_lightCDF[i + 1] = (totalPower > 0.0F) ? m_lightCDF[i + 1] / totalPower : 0.0F;
+	}
+}
+
+glm::vec3 BidirectionalIntegrator::trace(Ray const& ray, Sampler& sampler, TraceContext const& context) const
+{
+	assert(
+		m_pScene != nullptr
+		&& m_accel.isBuilt()
+		&& "Integrator needs scene data to be set"
+	);
+	assert(context.camera != nullptr && "Bidirectional integrator requires a camera");
+
+	Camera const& camera = *context.camera;
+
+	// Generate subpaths, camera subpaths escaping the scene gather environment radiance directly
+	PathVertex cameraPath[MaxBounceDepth + 2];
+	PathVertex lightPath[MaxBounceDepth + 1];
+	glm::vec3 energy{};
+	uint32_t const cameraVertexCount = generateCameraSubpath(ray, sampler, camera, cameraPath, energy);
+	uint32_t const lightVertexCount = generateLightSubpath(sampler, lightPath);
+
+	// Evaluate all connection strategies
+	for (uint32_t t = 1; t <= cameraVertexCount; t++)
+	{
+		for (uint32_t s = 0; s <= lightVertexCount; s++)
+		{
+			int32_t const depth = static_cast<int32_t>(s + t) - 2;
+			if ((s == 1 && t == 1) || depth < 0 || depth > static_cast<int32_t>(m_maxBounceDepth)) {
+				continue;
+			}
+
+			// Light tracing strategies need a film to splat to, e.g. coarse preview passes do not provide one
+			if (t == 1 && context.film == nullptr) {
+				continue;
+			}
+
+			glm::vec2 splatUV{};
+			glm::vec3 const contribution = connect(lightPath, cameraPath, s, t, sampler, camera, splatUV);
+			if (t == 1)
+			{
+				// Light tracing strategy, contributes to the pixel the light vertex projects onto
+				if (!isBlack(contribution)) {
+					context.film->splat(splatUV, contribution);
+				}
+			}
+			else
+			{
+				energy += contribution;
+			}
+		}
+	}
+
+	return energy;
+}
+
+uint32_t BidirectionalIntegrator::generateCameraSubpath(Ray const& ray, Sampler& sampler, Camera const& camera, PathVertex* path, glm::vec3& escaped) const
+{
+	// Camera vertex, primary ray importance is cancelled by its PDF
+	PathVertex& vertex = path[0];
+	vertex.type = PathVertex::Type::Camera;
+	vertex.position = ray.O;
+	vertex.normal = camera.forward;
+	vertex.TBN = glm::mat3(1.0F);
+	vertex.wi = glm::vec3(0.0F);
+	vertex.material = nullptr;
+	vertex.light = NoLight;
+	vertex.beta = glm::vec3(1.0F);
+	vertex.pdfFwd = 1.0F;
+	vertex.pdfRev = 0.0F;
+
+	float const pdfDir = camera.evaluateDirectionPDF(ray.D);
+	tinybvh::Ray const primary({ ray.O.x, ray.O.y, ray.O.z }, { ray.D.x, ray.D.y, ray.D.z });
+	return 1 + randomWalk(primary, sampler, vertex.beta, pdfDir, m_maxBounceDepth + 1, true, path + 1, escaped);
+}
+
+uint32_t BidirectionalIntegrator::generateLightSubpath(Sampler& sampler, PathVertex* path) const
+{
+	glm::vec3 position{};
+	glm::vec3 lightNormal{};
+	float pdfChoice = 0.0F;
+	uint32_t const lightIdx = sampleLight(sampler, position, lightNormal, pdfChoice);
+	if (lightIdx == NoLight) {
+		return 0;
+	}
+
+	// Emitters are two sided, pick a side & sample a cosine weighted direction
+	Emitter const& light = m_lights[lightIdx];
+	glm::vec3 const normal = (sampler.sample() < 0.5F) ? lightNormal : -lightNormal;
+	glm::vec3 const direction = createBasis(normal) * sampleCosineWeightedHemisphere(sampler);
+	float const cosTheta = glm::dot(direction, normal);
+	float const pdfPos = 1.0F / light.area;
+	float const pdfDir = cosTheta * INV_2PI;
+	if (cosTheta <= 0.0F) {
+		return 0;
+	}
+
+	PathVertex& vertex = path[0];
+	vertex.type = PathVertex::Type::Light;
+	vertex.position = position;
+	vertex.normal = normal;
+	vertex.TBN = createBasis(normal);
+	vertex.wi = glm::vec3(0.0F);
+	vertex.material = nullptr;
+	vertex.light = lightIdx;
+	vertex.beta = light.emission / (pdfChoice * pdfPos);
+	vertex.pdfFwd = pdfChoice * pdfPos;
+	vertex.pdfRev = 0.0F;
+
+	glm::vec3 const beta = light.emission * cosTheta / (pdfChoice * pdfPos * pdfDir);
+	glm::vec3 const origin = position + direction * RAY_EPSILON;
+	tinybvh::Ray const ray({ origin.x, origin.y, origin.z }, { direction.x, direction.y, direction.z });
+
+	glm::vec3 escaped{}; //< light paths escaping the scene carry no importance
+	return 1 + randomWalk(ray, sampler, beta, pdfDir, m_maxBounceDepth, false, path + 1, escaped);
+}
+
+uint32_t BidirectionalIntegrator::randomWalk(tinybvh::Ray ray, Sampler& sampler, glm::vec3 beta, float pdfDir, uint32_t maxDepth, bool isCameraPath, PathVertex* path, glm::vec3& escaped) const
+{
+	uint32_t bounces = 0;
+	float pdfFwd = pdfDir;
+	while (bounces < maxDepth)
+	{
+		PathVertex& prev = *(path + bounces - 1); //< path[-1] is the subpath origin
+		if (!m_accel.intersect(ray))
+		{
+			if (isCameraPath) {
+				escaped += beta * m_pScene->environment.evaluate(glm::vec3(ray.D.x, ray.D.y, ray.D.z));
+			}
+
+			break;
+		}
+
+		// Store surface vertex
+		SurfaceInteraction const surface = m_accel.getSurfaceInteraction(ray);
+		uint32_t light = NoLight;
+		if (surface.isAnalytic) {
+			light = m_primitiveLights[surface.primitive];
+		}
+		else if (m_instanceLightOffsets[surface.instance] != NoLight) {
+			light = m_instanceLightOffsets[surface.instance] + surface.primitive;
+		}
+
+		PathVertex& vertex = path[bounces];
+		vertex.type = PathVertex::Type::Surface;
+		vertex.position = surface.position;
+		vertex.normal = surface.normal;
+		vertex.TBN = surface.TBN;
+		vertex.wi = -glm::vec3(ray.D.x, ray.D.y, ray.D.z);
+		vertex.material = surface.material;
+		vertex.light = light;
+		vertex.beta = beta;
+		vertex.pdfRev = 0.0F;
+
+		glm::vec3 const toVertex = vertex.position - prev.position;
+		float const dist2 = glm::dot(toVertex, toVertex);
+		vertex.pdfFwd = (dist2 > 0.0F) ? pdfFwd * glm::abs(glm::dot(vertex.normal, toVertex / glm::sqrt(dist2))) / dist2 : 0.0F;
+
+		bounces++;
+		if (bounces >= maxDepth) {
+			break;
+		}
+
+		// Sample BRDF for next direction
+		glm::mat3 const iTBN(glm::transpose(vertex.TBN));
+		glm::vec3 const shadingNormal(0.0F, 0.0F, 1.0F);
+		glm::vec3 const wi = iTBN * vertex.wi;
+		glm::vec3 wo;
+		float pdf = 0.0F;
+		glm::vec3 const weight = sampleDisneyBRDF(sampler, *vertex.material, wi, shadingNormal, wo, pdf);
+		if (!(pdf > 0.0F) || isBlack(weight)) {
+			break;
+		}
+
+		// Store reverse density for the previous vertex
+		float pdfRev = 0.0F;
+		evaluateDisneyBRDF(*vertex.material, wo, shadingNormal, wi, pdfRev);
+
+		glm::vec3 const toPrev = prev.position - vertex.position;
+		float const prevDist2 = glm::dot(toPrev, toPrev);
+		prev.pdfRev = pdfRev / prevDist2;
+		if (prev.type != PathVertex::Type::Camera) {
+			prev.pdfRev *= glm::abs(glm::dot(prev.normal, toPrev / glm::sqrt(prevDist2)));
+		}
+
+		// Set up outgoing ray
+		beta *= weight;
+		pdfFwd = pdf;
+
+		glm::vec3 const D = vertex.TBN * wo;
+		glm::vec3 const O = vertex.position + D * RAY_EPSILON;
+		ray = tinybvh::Ray({ O.x, O.y, O.z }, { D.x, D.y, D.z });
+	}
+
+	return bounces;
+}
+
+glm::vec3 BidirectionalIntegrator::connect(
+	PathVertex const* lightPath, PathVertex const* cameraPath, uint32_t s, uint32_t t,
+	Sampler& sampler, Camera const& camera, glm::vec2& splatUV
+) const
+{
+	glm::vec3 contribution{};
+	PathVertex sampled{};
+	if (s == 0)
+	{
+		// Camera subpath hit an emitter
+		PathVertex const& pt = cameraPath[t - 1];
+		if (pt.light == NoLight) {
+			return glm::vec3(0.0F);
+		}
+
+		contribution = pt.beta * m_lights[pt.light].emission;
+	}
+	else if (t == 1)
+	{
+		// Connect light subpath to the camera
+		PathVertex const& qs = lightPath[s - 1];
+		if (!camera.projectPoint(qs.position, splatUV)) {
+			return glm::vec3(0.0F);
+		}
+
+		glm::vec3 const toCamera = camera.position - qs.position;
+		float const dist2 = glm::dot(toCamera, toCamera);
+		glm::vec3 const direction = -toCamera / glm::sqrt(dist2);
+		float const importance = camera.evaluateImportance(direction);
+		float const cosTheta = glm::dot(direction, camera.forward);
+
+		contribution = qs.beta * evaluateBRDF(qs, camera.position) * (importance * cosTheta / dist2);
+		if (isBlack(contribution) || !isVisible(qs.position, camera.position)) {
+			return glm::vec3(0.0F);
+		}
+	}
+	else if (s == 1)
+	{
+		// Sample a new light vertex (next event estimation)
+		PathVertex const& pt = cameraPath[t - 1];
+
+		glm::vec3 position{};
+		glm::vec3 lightNormal{};
+		float pdfChoice = 0.0F;
+		uint32_t const lightIdx = sampleLight(sampler, position, lightNormal, pdfChoice);
+		if (lightIdx == NoLight) {
+			return glm::vec3(0.0F);
+		}
+
+		Emitter const& light = m_lights[lightIdx];
+		glm::vec3 const toLight = position - pt.position;
+		float const dist2 = glm::dot(toLight, toLight);
+		float const cosLight = glm::abs(glm::dot(lightNormal, toLight / glm::sqrt(dist2)));
+		if (cosLight <= 0.0F) {
+			return glm::vec3(0.0F);
+		}
+
+		// Convert area density to solid angle density for the light sample weight
+		float const pdfPos = 1.0F / light.area;
+		float const pdfSolidAngle = pdfPos * dist2 / cosLight;
+
+		sampled.type = PathVertex::Type::Light;
+		sampled.position = position;
+		sampled.normal = lightNormal;
+		sampled.TBN = createBasis(lightNormal);
+		sampled.wi = glm::vec3(0.0F);
+		sampled.material = nullptr;
+		sampled.light = lightIdx;
+		sampled.beta = light.emission / (pdfChoice * pdfSolidAngle);
+		sampled.pdfFwd = pdfChoice * pdfPos;
+		sampled.pdfRev = 0.0F;
+
+		contribution = pt.beta * evaluateBRDF(pt, sampled.position) * sampled.beta;
+		if (isBlack(contribution) || !isVisible(pt.position, sampled.position)) {
+			return glm::vec3(0.0F);
+		}
+	}
+	else
+	{
+		// Connect two surface vertices
+		PathVertex const& qs = lightPath[s - 1];
+		PathVertex const& pt = cameraPath[t - 1];
+
+		glm::vec3 const d = qs.position - pt.position;
+		float const dist2 = glm::dot(d, d);
+		contribution = qs.beta * evaluateBRDF(qs, pt.position) * evaluateBRDF(pt, qs.position) * pt.beta / dist2;
+		if (isBlack(contribution) || !isVisible(pt.position, qs.position)) {
+			return glm::vec3(0.0F);
+		}
+	}
+
+	if (isBlack(contribution)) {
+		return contribution;
+	}
+
+	return contribution * misWeight(lightPath, cameraPath, sampled, s, t, camera);
+}
+
+float BidirectionalIntegrator::misWeight(
+	PathVertex const* lightPath, PathVertex const* cameraPath, PathVertex const& sampled, uint32_t s, uint32_t t,
+	Camera const& camera
+) const
+{
+	if (s + t == 2) {
+		return 1.0F;
+	}
+
+	// Get connection vertices, a sampled light vertex replaces the light subpath endpoint
+	PathVertex const* qs = (s == 1) ? &sampled : (s > 0 ? &lightPath[s - 1] : nullptr);
+	PathVertex const* pt = (t > 0) ? &cameraPath[t - 1] : nullptr;
+	PathVertex const* qsMinus = (s > 1) ? &lightPath[s - 2] : nullptr;
+	PathVertex const* ptMinus = (t > 1) ? &cameraPath[t - 2] : nullptr;
+
+	// Calculate reverse densities of the connection vertices & their predecessors for this strategy
+	float const ptPdfRev = (s > 0) ? evaluatePDF(camera, qsMinus, *qs, *pt) : evaluateLightOriginPDF(*pt);
+	float const ptMinusPdfRev = (ptMinus == nullptr) ? 0.0F : ((s > 0) ? evaluatePDF(camera, qs, *pt, *ptMinus) : evaluateLightPDF(*pt, *ptMinus));
+	float const qsPdfRev = (qs == nullptr) ? 0.0F : evaluatePDF(camera, ptMinus, *pt, *qs);
+	float const qsMinusPdfRev = (qsMinus == nullptr) ? 0.0F : evaluatePDF(camera, pt, *qs, *qsMinus);
+
+	// Sum density ratios of hypothetical strategies along the camera subpath (balance heuristic)
+	float sumRi = 0.0F;
+	float ri = 1.0F;
+	for (uint32_t i = t - 1; i > 0; i--)
+	{
+		float const pdfRev = (i == t - 1) ? ptPdfRev : ((i == t - 2) ? ptMinusPdfRev : cameraPath[i].pdfRev);
+		ri *= remap0(pdfRev) / remap0(cameraPath[i].pdfFwd);
+		sumRi += ri;
+	}
+
+	// Sum density ratios of hypothetical strategies along the light subpath
+	ri = 1.0F;
+	for (uint32_t i = s; i > 0; i--)
+	{
+		uint32_t const idx = i - 1;
+		float const pdfRev = (idx == s - 1) ? qsPdfRev : ((idx + 2 == s) ? qsMinusPdfRev : lightPath[idx].pdfRev);
+		float const pdfFwd = (idx == s - 1) ? qs->pdfFwd : lightPath[idx].pdfFwd;
+		ri *= remap0(pdfRev) / remap0(pdfFwd);
+		sumRi += ri;
+	}
+
+	return 1.0F / (1.0F + sumRi);
+}
+
+uint32_t BidirectionalIntegrator::sampleLight(Sampler& sampler, glm::vec3& position, glm::vec3& normal, float& pdfChoice) const
+{
+	if (m_lights.empty() || m_lightCDF.back() <= 0.0F) {
+		return NoLight;
+	}
+
+	// Pick light from power CDF
+	float const u = sampler.sample();
+	auto const it = std::upper_bound(m_lightCDF.begin(), m_lightCDF.end(), u);
+	size_t const idx = glm::clamp<size_t>(static_cast<size_t>(it - m_lightCDF.begin()) - 1, 0, m_lights.size() - 1);
+	pdfChoice = m_lightPDFs[idx];
+	if (pdfChoice <= 0.0F) {
+		return NoLight;
+	}
+
+	// Analytic emitters sample their own surface uniformly
+	Emitter const& light = m_lights[idx];
+	if (light.primitive != NoLight)
+	{
+		position = m_pScene->primitives[light.primitive].sampleArea(sampler, normal);
+		return static_cast<uint32_t>(idx);
+	}
+
+	// Uniformly sample triangle area
+	normal = light.normal;
+	glm::vec2 const eta = sampler.sample2D();
+	float const su = glm::sqrt(eta.x);
+	float const b0 = 1.0F - su;
+	float const b1 = eta.y * su;
+	position = b0 * light.p0 + b1 * light.p1 + (1.0F - b0 - b1) * light.p2;
+	return static_cast<uint32_t>(idx);
+}
+
+glm::vec3 BidirectionalIntegrator::evaluateBRDF(PathVertex const& vertex, glm::vec3 const& next) const
+{
+	assert(vertex.type == PathVertex::Type::Surface);
+
+	glm::mat3 const iTBN(glm::transpose(vertex.TBN));
+	glm::vec3 const wo = glm::normalize(next - vertex.position);
+	float pdf = 0.0F;
+	return evaluateDisneyBRDF(*vertex.material, iTBN * vertex.wi, glm::vec3(0.0F, 0.0F, 1.0F), iTBN * wo, pdf);
+}
+
+float BidirectionalIntegrator::evaluatePDF(Camera const& camera, PathVertex const* prev, PathVertex const& vertex, PathVertex const& next) const
+{
+	if (vertex.type == PathVertex::Type::Light) {
+		return evaluateLightPDF(vertex, next);
+	}
+
+	glm::vec3 const toNext = next.position - vertex.position;
+	float const dist2 = glm::dot(toNext, toNext);
+	if (dist2 <= 0.0F) {
+		return 0.0F;
+	}
+
+	// Evaluate solid angle density of sampling next from vertex
+	glm::vec3 const wn = toNext / glm::sqrt(dist2);
+	float pdf = 0.0F;
+	if (vertex.type == PathVertex::Type::Camera)
+	{
+		pdf = camera.evaluateDirectionPDF(wn);
+	}
+	else
+	{
+		assert(prev != nullptr);
+		glm::mat3 const iTBN(glm::transpose(vertex.TBN));
+		glm::vec3 const wp = glm::normalize(prev->position - vertex.position);
+		evaluateDisneyBRDF(*vertex.material, iTBN * wp, glm::vec3(0.0F, 0.0F, 1.0F), iTBN * wn, pdf);
+	}
+
+	// Convert to area density
+	if (next.type != PathVertex::Type::Camera) {
+		pdf *= glm::abs(glm::dot(next.normal, wn));
+	}
+
+	return pdf / dist2;
+}
+
+float BidirectionalIntegrator::evaluateLightPDF(PathVertex const& vertex, PathVertex const& next) const
+{
+	glm::vec3 const toNext = next.position - vertex.position;
+	float const dist2 = glm::dot(toNext, toNext);
+	if (dist2 <= 0.0F) {
+		return 0.0F;
+	}
+
+	// Cosine weighted emission over both sides of the emitter
+	glm::vec3 const wn = toNext / glm::sqrt(dist2);
+	float pdf = glm::abs(glm::dot(vertex.normal, wn)) * INV_2PI / dist2;
+	if (next.type != PathVertex::Type::Camera) {
+		pdf *= glm::abs(glm::dot(next.normal, wn));
+	}
+
+	return pdf;
+}
+
+float BidirectionalIntegrator::evaluateLightOriginPDF(PathVertex const& vertex) const
+{
+	assert(vertex.light != NoLight);
+	return m_lightPDFs[vertex.light] / m_lights[vertex.light].area;
+}
+
+bool BidirectionalIntegrator::isVisible(glm::vec3 const& from, glm::vec3 const& to) const
+{
+	glm::vec3 const d = to - from;
+	float const dist = glm::length(d);
+	if (dist <= 2.0F * RAY_EPSILON) {
+		return true;
+	}
+
+	glm::vec3 const D = d / dist;
+	glm::vec3 const O = from + D * RAY_EPSILON;
+	tinybvh::Ray const shadowRay({ O.x, O.y, O.z }, { D.x, D.y, D.z }, dist - 2.0F * RAY_EPSILON);
+	return !m_accel.isOccluded(shadowRay);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "accel.hpp"
+#include "integrator.hpp"
+
+/// @brief The BidirectionalIntegrator integrates a scene by connecting camera & light subpaths (Veach, Robust Monte Carlo Methods for Light Transport Simulation).
+/// Light subpaths start on emissive triangles & analytic primitives, contributions for paths with a single camera vertex are splatted to the film, or skipped if the context has no film.
+class BidirectionalIntegrator : public Integrator
+{
+public:
+	BidirectionalIntegrator() = default;
+	BidirectionalIntegrator(uint32_t maxBounceDepth);
+	~BidirectionalIntegrator() = default;
+
+	BidirectionalIntegrator(BidirectionalIntegrator const&) = default;
+	BidirectionalIntegrator &operator=(BidirectionalIntegrator const&) = default;
+
+	void setSceneData(Scene const& scene) override;
+
+	Scene const* getSceneData() const override { return m_pScene; }
+
+	std::unique_ptr<Integrator> clone() const override { return std::make_unique<BidirectionalIntegrator>(*this); }
+
+	glm::vec3 trace(Ray const& ray, Sampler& sampler, TraceContext const& context) const override;
+
+	bool usesSplatting() const override { return true; }
+
+	AccelerationStructure const& getAccelerationStructure() const override { return m_accel; }
+
+public:
+	/// @brief Maximum supported bounce depth, subpath vertices are stored on the stack.
+	static constexpr uint32_t MaxBounceDepth = 32;
+
+private:
+	/// @brief Emissive triangle or analytic primitive, analytic emitters are sampled by area.
+	struct Emitter
+	{
+		glm::vec3 p0;
+		glm::vec3 p1;
+		glm::vec3 p2;
+		glm::vec3 normal;
+		glm::vec3 emission;
+		float area;
+		uint32_t primitive;	//< scene primitive index, NoLight for triangles
+	};
+
+	struct PathVertex
+	{
+		enum class Type
+		{
+			Camera,
+			Light,
+			Surface,
+		};
+
+		Type			type;
+		glm::vec3		position;
+		glm::vec3		normal;
+		glm::mat3		TBN;
+		glm::vec3		wi;			//< world space direction towards the previous vertex
+		Material const*	material;
+		uint32_t		light;		//< emitter index, NoLight for non emissive vertices
+		glm::vec3		beta;		//< subpath throughput up to this vertex
+		float			pdfFwd;		//< area density of sampling this vertex from the previous vertex
+		float			pdfRev;		//< area density of sampling this vertex from the next vertex
+	};
+
+	static constexpr uint32_t NoLight = ~0U;
+
+private:
+	uint32_t generateCameraSubpath(Ray const& ray, Sampler& sampler, Camera const& camera, PathVertex* path, glm::vec3& escaped) const;
+
+	uint32_t generateLightSubpath(Sampler& sampler, PathVertex* path) const;
+
+	uint32_t randomWalk(tinybvh::Ray ray, Sampler& sampler, glm::vec3 beta, float pdfDir, uint32_t maxDepth, bool isCameraPath, PathVertex* path, glm::vec3& escaped) const;
+
+	glm::vec3 connect(
+		PathVertex const* lightPath, PathVertex const* cameraPath, uint32_t s, uint32_t t,
+		Sampler& sampler, Camera const& camera, glm::vec2& splatUV
+	) const;
+
+	float misWeight(
+		PathVertex const* lightPath, PathVertex const* cameraPath, PathVertex const& sampled, uint32_t s, uint32_t t,
+		Camera const& camera
+	) const;
+
+	/// @brief Sample a point on an emitter, choosing emitters proportional to their power.
+	/// @param sampler
+	/// @param position Output parameter containing the sampled position.
+	/// @param normal Output parameter containing the emitter normal at the sampled position.
+	/// @param pdfChoice Output parameter containing the discrete probability of choosing the light.
+	/// @return Index of the sampled emitter, NoLight if the scene has no lights.
+	uint32_t sampleLight(Sampler& sampler, glm::vec3& position, glm::vec3& normal, float& pdfChoice) const;
+
+	glm::vec3 evaluateBRDF(PathVertex const& vertex, glm::vec3 const& next) const;
+
+	float evaluatePDF(Camera const& camera, PathVertex const* prev, PathVertex const& vertex, PathVertex const& next) const;
+
+	float evaluateLightPDF(PathVertex const& vertex, PathVertex const& next) const;
+
+	float evaluateLightOriginPDF(PathVertex const& vertex) const;
+
+	bool isVisible(glm::vec3 const& from, glm::vec3 const& to) const;
+
+private:
+	uint32_t						m_maxBounceDepth		= 5;
+	Scene const*					m_pScene				= nullptr;
+
+	// -- Lights --
+	std::vector<Emitter>			m_lights				= {};
+	std::vector<float>				m_lightPDFs				= {};
+	std::vector<float>				m_lightCDF				= {};
+	std::vector<uint32_t>			m_instanceLightOffsets	= {}; //< first emitter per mesh instance, NoLight for non emissive instances
+	std::vector<uint32_t>			m_primitiveLights		= {}; //< emitter per scene primitive, NoLight for non emissive primitives
+
+	// -- Acceleration Structures --
+	AccelerationStructure			m_accel					= {};
+};
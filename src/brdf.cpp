@@ -82,6 +82,20 @@ float G1Schlick(glm::vec3 const& v, glm::vec3 const& n, float alpha)
 	return NoV / (NoV - (k * NoV) + k);
 }
 
+/// @brief Calculate the Fresnel response at normal incidence for a material.
+/// @param material 
+/// @return Lerped F0 between dielectric and metallic response.
+glm::vec3 calculateF0(Material const& material)
+{
+	// Calculate F0 constants for dielectric material
+	float const eta1 = material.IOR - 1.0F;
+	float const eta2 = material.IOR + 1.0F;
+	float const iorRatio = eta1 / eta2;
+
+	// Lerp between dielectric and metallic F0
+	return glm::mix(glm::vec3(iorRatio * iorRatio), material.baseColor, material.metallic);
+}
+
 glm::vec3 evaluateDisneyDiffuseBRDF(glm::vec3 const& baseColor, float alpha, glm::vec3 const& wi, glm::vec3 const& wo, glm::vec3 const& m, glm::vec3 const& n)
 {
 	float const F90 = 0.5F + 2.0F * alpha * glm::dot(wi, m) * glm::dot(wi, m);
@@ -127,60 +141,85 @@ glm::vec3 sampleLambertianDiffuseBRDF(Sampler& sampler, Material const& material
 	return (brdf * glm::dot(wo, n)) / pdf;
 }
 
-glm::vec3 sampleDisneyBRDF(Sampler& sampler, Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3& wo)
+/// @brief Calculate the lobe selection probabilities of the Disney BRDF.
+/// Weights only depend on the view direction, so sampling & evaluation agree on them for any outgoing direction.
+/// @param material 
+/// @param wi Incoming view direction.
+/// @param n Shading normal.
+/// @param diffWeight Output parameter containing the probability of sampling the diffuse lobe.
+/// @param specWeight Output parameter containing the probability of sampling the specular lobe.
+static void calculateLobeWeights(Material const& material, glm::vec3 const& wi, glm::vec3 const& n, float& diffWeight, float& specWeight)
 {
-	// Set up microfacet model parameters for Disney BSDF & sample specular lobe
-	float const alpha = glm::max(material.roughness * material.roughness, 1e-3F);
-	glm::vec3 const m = sampleGGX(sampler, alpha);
-
-	// Calculate F0 constants for dielectric material
-	float const eta1 = material.IOR - 1.0F;
-	float const eta2 = material.IOR + 1.0F;
-	float const iorRatio = eta1 / eta2;
-
-	// Lerp between dielectric and metallic F0 & calculate microfacet Fresnel
-	glm::vec3 const F0 = glm::mix(glm::vec3(iorRatio * iorRatio), material.baseColor, material.metallic);
-	glm::vec3 const F = FSchlick(wi, m, F0);
+	// Only sample diffuse when dielectric is non-zero, sample specular based on Fresnel luma at the shading normal
+	diffWeight = 1.0F - material.metallic;
+	specWeight = luma(FSchlick(wi, n, calculateF0(material)));
 
-	// Evaluate diffuse & sepcular directions
-	glm::vec3 const diffwo = sampleCosineWeightedHemisphere(sampler);
-	glm::vec3 const specwo = glm::reflect(-wi, m);
+	float const totalWeight = diffWeight + specWeight;
+	if (totalWeight <= 0.0F)
+	{
+		diffWeight = 1.0F;
+		specWeight = 0.0F;
+		return;
+	}
 
-	// Calculate lobe PDFs
-	float const diffPDF = evaluateCosineWeightedPDF(n, diffwo);
-	float const specPDF = evaluateGGXPDF(alpha, m, n, specwo);
+	diffWeight /= totalWeight;
+	specWeight /= totalWeight;
+}
 
-	// Calculate normalized lobe sample weights
-	float diffWeight = 1.0F - material.metallic;	// Only sample diffuse when dielectric is non-zero
-	float specWeight = luma(F);						// Sample specular based on Fresnel luma
-	float const invWeights = 1.0F / (diffWeight + specWeight);
-	diffWeight *= invWeights;
-	specWeight *= invWeights;
+glm::vec3 sampleDisneyBRDF(Sampler& sampler, Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3& wo, float& pdf)
+{
+	float diffWeight = 0.0F;
+	float specWeight = 0.0F;
+	calculateLobeWeights(material, wi, n, diffWeight, specWeight);
 
-	glm::vec3 brdf{};
-	float pdf = 0.0F;
-	float pdfWeight = 0.0F;
 	if (sampler.sample() < diffWeight)
 	{
 		// Lambertian diffuse w/ highlight
-		brdf = evaluateDisneyDiffuseBRDF(material.baseColor, alpha, wi, diffwo, m, n);
-		pdf = diffPDF;
-		pdfWeight = diffWeight;
-
-		wo = diffwo;
+		wo = sampleCosineWeightedHemisphere(sampler);
 	}
 	else
 	{
-		// Cook-Torrance BSDF using Walter et al. formulation
-		brdf = evaluateDisneySpecularBRDF(alpha, F0, wi, specwo, m, n);
-		pdf = specPDF;
-		pdfWeight = specWeight;
+		// Reflect the view direction around a GGX microfacet normal
+		float const alpha = glm::max(material.roughness * material.roughness, 1e-3F);
+		glm::vec3 const m = sampleGGX(sampler, alpha);
+		wo = glm::reflect(-wi, m);
+	}
 
-		wo = specwo;
+	// One-sample MIS over both lobes (balance heuristic): the full BRDF is divided by the composite lobe PDF,
+	// which makes the sample weight equal to evaluateDisneyBRDF / pdf for the sampled direction
+	glm::vec3 const brdf = evaluateDisneyBRDF(material, wi, n, wo, pdf);
+	if (!(pdf > 0.0F)) {
+		pdf = 0.0F;
+		return glm::vec3(0.0F);
 	}
 
-	// Calculate composite MIS PDF & this MIS sample's weight
-	float const compositePDF = (diffWeight * diffPDF + specWeight * specPDF);
-	float const MISWeight = (pdfWeight * pdf) / compositePDF;
-	return MISWeight * ((brdf * glm::abs(glm::dot(wo, n))) / pdf);
+	return brdf / pdf;
+}
+
+glm::vec3 evaluateDisneyBRDF(Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3 const& wo, float& pdf)
+{
+	// Directions below the shading hemisphere receive no contribution
+	float const NoI = glm::dot(wi, n);
+	float const NoO = glm::dot(wo, n);
+	if (NoI <= 0.0F || NoO <= 0.0F)
+	{
+		pdf = 0.0F;
+		return glm::vec3(0.0F);
+	}
+
+	// Set up microfacet model parameters using the half vector as microfacet normal
+	float const alpha = glm::max(material.roughness * material.roughness, 1e-3F);
+	glm::vec3 const m = glm::normalize(wi + wo);
+	glm::vec3 const F0 = calculateF0(material);
+
+	float diffWeight = 0.0F;
+	float specWeight = 0.0F;
+	calculateLobeWeights(material, wi, n, diffWeight, specWeight);
+
+	// Evaluate lobes, diffuse lobe fades out for metallic materials
+	glm::vec3 const diffuse = evaluateDisneyDiffuseBRDF(material.baseColor, alpha, wi, wo, m, n);
+	glm::vec3 const specular = evaluateDisneySpecularBRDF(alpha, F0, wi, wo, m, n);
+
+	pdf = diffWeight * evaluateCosineWeightedPDF(n, wo) + specWeight * evaluateGGXPDF(alpha, m, n, wo);
+	return ((1.0F - material.metallic) * diffuse + specular) * NoO;
 }
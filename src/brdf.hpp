@@ -5,6 +5,35 @@
 #include "material.hpp"
 #include "sampler.hpp"
 
+/// @brief Calculate the Luma value of a color (linear RGB to luma)
+/// @param color 
+/// @return 
+float luma(glm::vec3 const& color);
+
+/// @brief Sample a cosine weighted hemisphere around the +Z axis.
+/// @param sampler 
+/// @return 
+glm::vec3 sampleCosineWeightedHemisphere(Sampler& sampler);
+
 glm::vec3 sampleLambertianDiffuseBRDF(Sampler& sampler, Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3& wo);
 
-glm::vec3 sampleDisneyBRDF(Sampler& sampler, Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3& wo);
+/// @brief Sample the Disney BRDF.
+/// A lobe is picked using the same probabilities as the composite PDF of evaluateDisneyBRDF, so the returned weight
+/// always equals evaluateDisneyBRDF / pdf for the sampled direction.
+/// @param sampler 
+/// @param material 
+/// @param wi Incoming view direction.
+/// @param n Shading normal.
+/// @param wo Output parameter containing the sampled outgoing direction.
+/// @param pdf Output parameter containing the composite lobe PDF of the sampled direction.
+/// @return The sample weight (BRDF * cosine / PDF), zero if the sampled direction is below the shading hemisphere.
+glm::vec3 sampleDisneyBRDF(Sampler& sampler, Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3& wo, float& pdf);
+
+/// @brief Evaluate the Disney BRDF for a known outgoing direction, used for light sampling.
+/// @param material 
+/// @param wi Incoming view direction.
+/// @param n Shading normal.
+/// @param wo Outgoing (light) direction.
+/// @param pdf Output parameter containing the composite lobe PDF of sampling wo using sampleDisneyBRDF.
+/// @return The cosine weighted BRDF value.
+glm::vec3 evaluateDisneyBRDF(Material const& material, glm::vec3 const& wi, glm::vec3 const& n, glm::vec3 const& wo, float& pdf);
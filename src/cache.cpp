@@ -0,0 +1,122 @@
+#include "cache.hpp"
+
+/// @brief Fixed point scale for accumulated radiance.
+static constexpr float FixedPointScale = 65536.0F;
+
+/// @brief Finalizer of splitmix64, distributes grid keys over the hash table.
+/// @param value
+/// @return
+static uint64_t mixBits(uint64_t value)
+{
+	value ^= value >> 30;
+	value *= 0xBF58476D1CE4E5B9ULL;
+	value ^= value >> 27;
+	value *= 0x94D049BB133111EBULL;
+	value ^= value >> 31;
+	return value;
+}
+
+RadianceCache::RadianceCache(float cellSize, size_t cellCount)
+	:
+	m_cellSize(cellSize)
+{
+	m_cellCount = 1;
+	while (m_cellCount < cellCount) {
+		m_cellCount <<= 1;
+	}
+
+	m_cells = std::make_unique<Cell[]>(m_cellCount);
+}
+
+void RadianceCache::insert(glm::vec3 const& position, glm::vec3 const& normal, glm::vec3 const& radiance)
+{
+	uint64_t const key = computeKey(position, normal);
+	size_t const mask = m_cellCount - 1;
+	size_t index = static_cast<size_t>(mixBits(key)) & mask;
+	for (uint32_t probe = 0; probe < MaxProbeCount; probe++, index = (index + 1) & mask)
+	{
+		// Claim empty cells, continue probing if the cell belongs to another key
+		Cell& cell = m_cells[index];
+		uint64_t cellKey = cell.key.load(std::memory_order_relaxed);
+		if (cellKey == 0 && cell.key.compare_exchange_strong(cellKey, key, std::memory_order_relaxed)) {
+			cellKey = key;
+		}
+
+		// On a failed claim cellKey contains the key of the thread that claimed the cell
+		if (cellKey != key) {
+			continue;
+		}
+
+		glm::vec3 const clamped = glm::clamp(radiance, glm::vec3(0.0F), glm::vec3(MaxRadiance));
+		for (int i = 0; i < 3; i++) {
+			cell.radiance[i].fetch_add(static_cast<uint64_t>(clamped[i] * FixedPointScale), std::memory_order_relaxed);
+		}
+
+		cell.sampleCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+}
+
+bool RadianceCache::query(glm::vec3 const& position, glm::vec3 const& normal, glm::vec3& radiance) const
+{
+	uint64_t const key = computeKey(position, normal);
+	size_t const mask = m_cellCount - 1;
+	size_t index = static_cast<size_t>(mixBits(key)) & mask;
+	for (uint32_t probe = 0; probe < MaxProbeCount; probe++, index = (index + 1) & mask)
+	{
+		Cell const& cell = m_cells[index];
+		uint64_t const cellKey = cell.key.load(std::memory_order_relaxed);
+		if (cellKey == 0) {
+			return false;
+		}
+
+		if (cellKey != key) {
+			continue;
+		}
+
+		uint32_t const sampleCount = cell.sampleCount.load(std::memory_order_relaxed);
+		if (sampleCount < MinSampleCount) {
+			return false;
+		}
+
+		float const scale = 1.0F / (FixedPointScale * static_cast<float>(sampleCount));
+		for (int i = 0; i < 3; i++) {
+			radiance[i] = static_cast<float>(cell.radiance[i].load(std::memory_order_relaxed)) * scale;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+size_t RadianceCache::occupiedCellCount() const
+{
+	size_t count = 0;
+	for (size_t i = 0; i < m_cellCount; i++)
+	{
+		if (m_cells[i].key.load(std::memory_order_relaxed) != 0) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+uint64_t RadianceCache::computeKey(glm::vec3 const& position, glm::vec3 const& normal) const
+{
+	// Quantize position to 20 bits per axis (wrapping for large scenes)
+	glm::vec3 const grid = glm::floor(position / m_cellSize);
+	uint64_t const x = static_cast<uint64_t>(static_cast<int64_t>(grid.x)) & 0xFFFFF;
+	uint64_t const y = static_cast<uint64_t>(static_cast<int64_t>(grid.y)) & 0xFFFFF;
+	uint64_t const z = static_cast<uint64_t>(static_cast<int64_t>(grid.z)) & 0xFFFFF;
+
+	// Separate cells by dominant normal axis & sign, avoids mixing radiance of thin walls & corners
+	glm::vec3 const absNormal = glm::abs(normal);
+	uint64_t const axis = (absNormal.x > absNormal.y && absNormal.x > absNormal.z) ? 0 : (absNormal.y > absNormal.z ? 1 : 2);
+	uint64_t const sign = normal[static_cast<int>(axis)] < 0.0F ? 1 : 0;
+	uint64_t const normalBucket = axis * 2 + sign;
+
+	// Offset by one so no key maps to the empty cell marker
+	return ((normalBucket << 60) | (z << 40) | (y << 20) | x) + 1;
+}
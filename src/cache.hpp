@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <glm/glm.hpp>
+
+/// @brief The RadianceCache stores reflected radiance in a world space hash grid.
+/// Cells are keyed by quantized position & dominant normal axis, samples are accumulated lock-free using fixed point atomics.
+/// Cached radiance ignores the view direction, so it is only valid for diffuse & rough surfaces.
+class RadianceCache
+{
+public:
+	/// @brief Create an empty radiance cache.
+	/// @param cellSize World space size of a grid cell.
+	/// @param cellCount Number of hash table cells, rounded up to a power of 2.
+	RadianceCache(float cellSize, size_t cellCount);
+
+	RadianceCache(RadianceCache const&) = delete;
+	RadianceCache& operator=(RadianceCache const&) = delete;
+
+	/// @brief Add a radiance sample to the cell containing a position, dropped if no cell is available within the probe limit.
+	/// @param position World space position.
+	/// @param normal World space surface normal.
+	/// @param radiance Reflected radiance sample.
+	void insert(glm::vec3 const& position, glm::vec3 const& normal, glm::vec3 const& radiance);
+
+	/// @brief Look up the cached radiance for a position.
+	/// @param position World space position.
+	/// @param normal World space surface normal.
+	/// @param radiance Output parameter containing the mean cached radiance.
+	/// @return true if the cell has enough samples to be used.
+	bool query(glm::vec3 const& position, glm::vec3 const& normal, glm::vec3& radiance) const;
+
+	/// @brief Count cells containing samples, not safe to call concurrently with insert.
+	/// @return
+	size_t occupiedCellCount() const;
+
+	/// @brief Get the size in bytes of the hash table.
+	/// @return
+	size_t memoryUsage() const { return m_cellCount * sizeof(Cell); }
+
+	size_t cellCount() const { return m_cellCount; }
+
+public:
+	/// @brief Min number of samples in a cell before it is used for queries.
+	static constexpr uint32_t MinSampleCount = 8;
+
+	/// @brief Max number of cells probed for a key before giving up.
+	static constexpr uint32_t MaxProbeCount = 8;
+
+	/// @brief Max radiance per channel stored in a sample, avoids fixed point overflow & firefly propagation.
+	static constexpr float MaxRadiance = 64.0F;
+
+private:
+	struct Cell
+	{
+		std::atomic<uint64_t>	key;			//< 0 for empty cells
+		std::atomic<uint64_t>	radiance[3];	//< fixed point RGB sums
+		std::atomic<uint32_t>	sampleCount;
+	};
+
+	uint64_t computeKey(glm::vec3 const& position, glm::vec3 const& normal) const;
+
+private:
+	float					m_cellSize	= 1.0F;
+	size_t					m_cellCount	= 0;
+	std::unique_ptr<Cell[]>	m_cells		= {};
+};
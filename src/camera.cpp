@@ -22,3 +22,50 @@ ViewPyramid Camera::generateViewPyramid() const
 		px01,
 	};
 }
+
+bool Camera::projectPoint(glm::vec3 const& point, glm::vec2& uv) const
+{
+	// Find intersection of point direction with the image plane at unit distance
+	glm::vec3 const direction = point - position;
+	float const cosTheta = glm::dot(direction, forward);
+	if (cosTheta <= 0.0F) {
+		return false;
+	}
+
+	float const viewportHeight = 2.0F * glm::tan(glm::radians(FOVy / 2.0F));
+	float const viewportWidth = viewportHeight * aspectRatio;
+	glm::vec3 const offset = (direction / cosTheta) - forward;
+
+	uv.x = glm::dot(offset, right) / viewportWidth + 0.5F;
+	uv.y = glm::dot(offset, -up) / viewportHeight + 0.5F;
+	return uv.x >= 0.0F && uv.x < 1.0F && uv.y >= 0.0F && uv.y < 1.0F;
+}
+
+float Camera::evaluateImportance(glm::vec3 const& direction) const
+{
+	glm::vec2 uv{};
+	if (!projectPoint(position + direction, uv)) {
+		return 0.0F;
+	}
+
+	// Importance is normalized such that it integrates to 1 over the image plane
+	float const viewportHeight = 2.0F * glm::tan(glm::radians(FOVy / 2.0F));
+	float const viewportArea = viewportHeight * viewportHeight * aspectRatio;
+	float const cosTheta = glm::dot(direction, forward);
+	float const cos2Theta = cosTheta * cosTheta;
+	return 1.0F / (viewportArea * cos2Theta * cos2Theta);
+}
+
+float Camera::evaluateDirectionPDF(glm::vec3 const& direction) const
+{
+	glm::vec2 uv{};
+	if (!projectPoint(position + direction, uv)) {
+		return 0.0F;
+	}
+
+	// Image plane area density converted to solid angle
+	float const viewportHeight = 2.0F * glm::tan(glm::radians(FOVy / 2.0F));
+	float const viewportArea = viewportHeight * viewportHeight * aspectRatio;
+	float const cosTheta = glm::dot(direction, forward);
+	return 1.0F / (viewportArea * cosTheta * cosTheta * cosTheta);
+}
@@ -19,6 +19,22 @@ public:
 	/// @return 
 	ViewPyramid generateViewPyramid() const;
 
+	/// @brief Project a world space point onto the camera image plane.
+	/// @param point 
+	/// @param uv Output parameter containing the normalized [0, 1] image plane coordinates of the point.
+	/// @return true if the point projects onto the image plane.
+	bool projectPoint(glm::vec3 const& point, glm::vec2& uv) const;
+
+	/// @brief Evaluate the pinhole camera importance for a direction leaving the camera.
+	/// @param direction Normalized world space direction.
+	/// @return Importance normalized over the full image plane, 0 if the direction is outside the view.
+	float evaluateImportance(glm::vec3 const& direction) const;
+
+	/// @brief Evaluate the solid angle PDF of generating a primary ray in a direction.
+	/// @param direction Normalized world space direction.
+	/// @return 
+	float evaluateDirectionPDF(glm::vec3 const& direction) const;
+
 public:
 	// -- Settings --//
 	float FOVy			= 60.0F;
@@ -0,0 +1,268 @@
+#include "checkpoint.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/// @brief Fixed size checkpoint file header, followed by sample counts, pixels & the optional splat film.
+struct CheckpointHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t fingerprint;
+	uint32_t resolutionX;
+	uint32_t resolutionY;
+	uint32_t sampleCount;
+	uint32_t usesSplatting;
+	uint64_t lightPathCount;
+};
+
+/// @brief Write an array to a file.
+/// @param file
+/// @param data
+/// @param count Number of elements.
+/// @return true if all elements were written.
+template<typename T>
+static bool writeArray(FILE* file, T const* data, size_t count)
+{
+	return fwrite(data, sizeof(T), count, file) == count;
+}
+
+/// @brief Read an array from a file.
+/// @param file
+/// @param data
+/// @param count Number of elements.
+/// @return true if all elements were read.
+template<typename T>
+static bool readArray(FILE* file, T* data, size_t count)
+{
+	return fread(data, sizeof(T), count, file) == count;
+}
+
+/// @brief Flush a file to stable storage, so a rename never exposes a partially written file after a crash.
+/// @param file
+/// @return true on success.
+static bool syncFile(FILE* file)
+{
+	if (fflush(file) != 0) {
+		return false;
+	}
+
+#ifdef _WIN32
+	return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)))) != 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+/// @brief Get the size of a file, leaves the file position at the start of the file.
+/// @param file
+/// @param size Output parameter containing the size in bytes.
+/// @return true on success.
+static bool getFileSize(FILE* file, uint64_t& size)
+{
+#ifdef _WIN32
+	if (_fseeki64(file, 0, SEEK_END) != 0) {
+		return false;
+	}
+
+	__int64 const end = _ftelli64(file);
+#else
+	if (fseeko(file, 0, SEEK_END) != 0) {
+		return false;
+	}
+
+	off_t const end = ftello(file);
+#endif
+	if (end < 0) {
+		return false;
+	}
+
+	size = static_cast<uint64_t>(end);
+	rewind(file);
+	return true;
+}
+
+/// @brief Atomically replace a file. On POSIX systems the parent directory is flushed as well, the rename itself is
+/// otherwise not durable & a crash could bring back the previous file.
+/// @param from
+/// @param to
+/// @return true on success.
+static bool replaceFile(std::string const& from, std::string const& to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	if (rename(from.c_str(), to.c_str()) != 0) {
+		return false;
+	}
+
+	size_t const separator = to.find_last_of('/');
+	std::string const directory = (separator == std::string::npos) ? "." : ((separator == 0) ? "/" : to.substr(0, separator));
+	int const descriptor = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+	if (descriptor < 0) {
+		return false;
+	}
+
+	bool const synced = fsync(descriptor) == 0;
+	close(descriptor);
+	return synced;
+#endif
+}
+
+void RenderCheckpoint::reset(uint32_t width, uint32_t height, uint32_t samples, bool splatting)
+{
+	size_t const pixelCount = static_cast<size_t>(width) * height;
+	resolutionX = width;
+	resolutionY = height;
+	sampleCount = samples;
+	usesSplatting = splatting;
+	lightPathCount = 0;
+	sampleCounts.assign(pixelCount, 0);
+	pixels.assign(pixelCount, glm::vec3(0.0F));
+	film.assign(splatting ? pixelCount : 0, glm::vec3(0.0F));
+}
+
+bool RenderCheckpoint::write(std::string const& path) const
+{
+	std::string const tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	CheckpointHeader const header{
+		Magic,
+		Version,
+		fingerprint,
+		resolutionX,
+		resolutionY,
+		sampleCount,
+		usesSplatting ? 1U : 0U,
+		lightPathCount,
+	};
+
+	bool const written = writeArray(file, &header, 1)
+		&& writeArray(file, sampleCounts.data(), sampleCounts.size())
+		&& writeArray(file, pixels.data(), pixels.size())
+		&& writeArray(file, film.data(), film.size())
+		&& syncFile(file);
+
+	if (fclose(file) != 0 || !written)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	return replaceFile(tempPath, path);
+}
+
+bool RenderCheckpoint::read(std::string const& path, RenderCheckpoint& checkpoint)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	// Check the file size against the header before allocating, a corrupt header could request any resolution
+	uint64_t fileSize = 0;
+	CheckpointHeader header{};
+	if (!getFileSize(file, fileSize) || !readArray(file, &header, 1) || header.magic != Magic || header.version != Version)
+	{
+		fclose(file);
+		return false;
+	}
+
+	uint64_t const pixelCount = static_cast<uint64_t>(header.resolutionX) * header.resolutionY;
+	uint64_t const pixelSize = sizeof(uint32_t) + sizeof(glm::vec3) + (header.usesSplatting != 0 ? sizeof(glm::vec3) : 0);
+	if (fileSize != sizeof(CheckpointHeader) + pixelCount * pixelSize)
+	{
+		fclose(file);
+		return false;
+	}
+
+	checkpoint.reset(header.resolutionX, header.resolutionY, header.sampleCount, header.usesSplatting != 0);
+	checkpoint.fingerprint = header.fingerprint;
+	checkpoint.lightPathCount = header.lightPathCount;
+
+	bool const complete = readArray(file, checkpoint.sampleCounts.data(), checkpoint.sampleCounts.size())
+		&& readArray(file, checkpoint.pixels.data(), checkpoint.pixels.size())
+		&& readArray(file, checkpoint.film.data(), checkpoint.film.size());
+
+	fclose(file);
+	return complete;
+}
+
+uint64_t hashFingerprint(void const* data, size_t size, uint64_t hash)
+{
+	uint8_t const* bytes = static_cast<uint8_t const*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
+
+CheckpointWriter::CheckpointWriter(std::string const& path, double interval, SnapshotCallback snapshot)
+	:
+	m_path(path),
+	m_interval(interval),
+	m_snapshot(std::move(snapshot))
+{
+	m_thread = std::thread(&CheckpointWriter::writeLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	stop();
+}
+
+void CheckpointWriter::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_stopRequested.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
+
+void CheckpointWriter::writeLoop()
+{
+	std::chrono::duration<double> const interval(m_interval);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stopRequested.wait_for(lock, interval, [this]() { return m_stopping; }))
+	{
+		// Snapshot & write without holding the lock, so stop requests are only delayed by an in-flight write
+		lock.unlock();
+		auto const writeStart = std::chrono::high_resolution_clock::now();
+		m_snapshot(m_checkpoint);
+		bool const written = m_checkpoint.write(m_path);
+		auto const writeEnd = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double> const writeTime = writeEnd - writeStart;
+		lock.lock();
+
+		if (!written) {
+			printf("Failed to write checkpoint %s\n", m_path.c_str());
+			continue;
+		}
+
+		m_writeCount.fetch_add(1, std::memory_order_relaxed);
+		printf("Wrote checkpoint %s in %.3f s\n", m_path.c_str(), writeTime.count());
+	}
+}
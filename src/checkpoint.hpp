@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// @brief Render state saved to disk, allowing an interrupted render to resume.
+/// Pixels are rendered with a deterministic per-pixel seed, so resumed pixels produce the same samples as an uninterrupted run.
+struct RenderCheckpoint
+{
+	static constexpr uint32_t Magic		= 0x4B435450; //< "PTCK"
+	static constexpr uint32_t Version	= 2;
+
+	uint64_t				fingerprint		= 0;	//< identifies the scene, integrator & pixel seeds, resuming requires a match
+	uint32_t				resolutionX		= 0;
+	uint32_t				resolutionY		= 0;
+	uint32_t				sampleCount		= 0;	//< target samples per pixel
+	bool					usesSplatting	= false;
+	uint64_t				lightPathCount	= 0;	//< light paths splatted to the film, normalizes the film on resolve
+	std::vector<uint32_t>	sampleCounts	= {};	//< samples accumulated per pixel
+	std::vector<glm::vec3>	pixels			= {};	//< averaged pixel values, only valid for pixels with samples
+	std::vector<glm::vec3>	film			= {};	//< splat film sums, empty for non splatting integrators
+
+	/// @brief Allocate cleared state for a render.
+	/// @param width
+	/// @param height
+	/// @param samples Target samples per pixel.
+	/// @param splatting Allocate a splat film.
+	void reset(uint32_t width, uint32_t height, uint32_t samples, bool splatting);
+
+	/// @brief Write the checkpoint to a temporary file & atomically replace the checkpoint file with it.
+	/// The file & the directory entry are flushed to stable storage, so the new checkpoint survives a crash once written.
+	/// @param path
+	/// @return true on success, the previous checkpoint file is left untouched on failure.
+	bool write(std::string const& path) const;
+
+	/// @brief Read a checkpoint file.
+	/// @param path
+	/// @param checkpoint Output parameter containing the checkpoint, only valid on success.
+	/// @return false if the file is missing, truncated, of the wrong size for its header or not a checkpoint.
+	static bool read(std::string const& path, RenderCheckpoint& checkpoint);
+};
+
+/// @brief Hash bytes into a checkpoint fingerprint (FNV-1a).
+/// @param data
+/// @param size
+/// @param hash Hash to continue from, allows combining multiple values.
+/// @return
+uint64_t hashFingerprint(void const* data, size_t size, uint64_t hash = 0xCBF29CE484222325ULL);
+
+/// @brief The CheckpointWriter periodically snapshots render state on a background thread & writes it to disk.
+/// Render workers keep running, the snapshot callback must only read state that is safe to read concurrently or synchronize with workers.
+class CheckpointWriter
+{
+public:
+	using SnapshotCallback = std::function<void(RenderCheckpoint&)>;
+
+	/// @brief Start writing checkpoints.
+	/// @param path Checkpoint file path.
+	/// @param interval Seconds between checkpoints.
+	/// @param snapshot Callback filling a checkpoint with the current render state.
+	CheckpointWriter(std::string const& path, double interval, SnapshotCallback snapshot);
+	~CheckpointWriter();
+
+	CheckpointWriter(CheckpointWriter const&) = delete;
+	CheckpointWriter& operator=(CheckpointWriter const&) = delete;
+
+	/// @brief Stop writing checkpoints & join the background thread, an in-flight write is completed first.
+	void stop();
+
+	/// @brief Get the number of checkpoints written, safe to call while the writer is running.
+	/// @return
+	uint32_t writeCount() const { return m_writeCount.load(std::memory_order_relaxed); }
+
+private:
+	void writeLoop();
+
+private:
+	std::string				m_path			= {};
+	double					m_interval		= 0.0;
+	SnapshotCallback		m_snapshot		= {};
+	RenderCheckpoint		m_checkpoint	= {}; //< reused between snapshots
+
+	// -- Writer Thread State --
+	std::thread				m_thread		= {};
+	std::mutex				m_mutex			= {};
+	std::condition_variable	m_stopRequested	= {};
+	bool					m_stopping		= false;
+	std::atomic<uint32_t>	m_writeCount	= { 0 };
+};
@@ -0,0 +1,232 @@
+#include "environment.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+#include <stb_image.h>
+
+#include "brdf.hpp"
+
+static constexpr float PI		= 3.14159265358979F;
+static constexpr float TWO_PI	= 2.0F * PI;
+static constexpr float INV_PI	= 1.0F / PI;
+static constexpr float INV_2PI	= 1.0F / TWO_PI;
+
+/// @brief Sample a piecewise constant 1D distribution.
+/// @param func Distribution function values.
+/// @param cdf Normalized distribution CDF, containing count + 1 values.
+/// @param count Number of function values.
+/// @param integral Integral of the distribution function over [0, 1].
+/// @param u Uniform random value in range [0, 1].
+/// @param pdf Output parameter containing the PDF of the sampled value.
+/// @param offset Output parameter containing the index of the sampled function value.
+/// @return A continuous sample in range [0, 1].
+static float sampleContinuous1D(float const* func, float const* cdf, uint32_t count, float integral, float u, float& pdf, uint32_t& offset)
+{
+	// Find the CDF segment containing u
+	float const* segment = std::upper_bound(cdf, cdf + count + 1, u);
+	offset = static_cast<uint32_t>(glm::clamp<std::ptrdiff_t>((segment - cdf) - 1, 0, static_cast<std::ptrdiff_t>(count) - 1));
+
+	// Remap u to the segment
+	float du = u - cdf[offset];
+	float const segmentSize = cdf[offset + 1] - cdf[offset];
+	if (segmentSize > 0.0F) {
+		du /= segmentSize;
+	}
+
+	pdf = (integral > 0.0F) ? func[offset] / integral : 0.0F;
+	return (static_cast<float>(offset) + du) / static_cast<float>(count);
+}
+
+/// @brief Build a normalized CDF for a piecewise constant 1D distribution.
+/// @param func Distribution function values.
+/// @param count Number of function values.
+/// @param cdf Output CDF, must have space for count + 1 values.
+/// @return The integral of the distribution function over [0, 1].
+static float buildCDF1D(float const* func, uint32_t count, float* cdf)
+{
+	cdf[0] = 0.0F;
+	for (uint32_t i = 0; i < count; i++) {
+		cdf[i + 1] = cdf[i] + func[i] / static_cast<float>(count);
+	}
+
+	float const integral = cdf[count];
+	for (uint32_t i = 1; i <= count; i++)
+	{
+		// Fall back to a uniform distribution for zero valued functions
+		cdf[i] = (integral > 0.0F) ? cdf[i] / integral : static_cast<float>(i) / static_cast<float>(count);
+	}
+
+	return integral;
+}
+
+/// @brief Convert a world space direction to equirectangular UV coordinates.
+/// @param direction
+/// @return
+static glm::vec2 directionToUV(glm::vec3 const& direction)
+{
+	float const theta = glm::acos(glm::clamp(direction.y, -1.0F, 1.0F));
+	float const phi = glm::atan(direction.z, direction.x);
+
+	return glm::vec2((phi + PI) * INV_2PI, theta * INV_PI);
+}
+
+/// @brief Convert equirectangular UV coordinates to a world space direction.
+/// @param uv
+/// @return
+static glm::vec3 uvToDirection(glm::vec2 const& uv)
+{
+	float const theta = uv.y * PI;
+	float const phi = uv.x * TWO_PI - PI;
+
+	return glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+}
+
+Environment::Environment(uint32_t width, uint32_t height, std::vector<glm::vec3> pixels)
+	:
+	m_width(width),
+	m_height(height),
+	m_pixels(std::move(pixels))
+{
+	assert(m_pixels.size() == static_cast<size_t>(m_width) * m_height);
+	buildSamplingTables();
+}
+
+Environment Environment::fromFile(std::string const& path)
+{
+	// Read image from disk as linear float data
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	float* data = stbi_loadf(path.c_str(), &width, &height, &channels, 3);
+	if (data == nullptr) {
+		printf("Failed to load environment %s: %s\n", path.c_str(), stbi_failure_reason());
+		return {};
+	}
+
+	std::vector<glm::vec3> pixels(static_cast<size_t>(width) * height);
+	for (size_t i = 0; i < pixels.size(); i++) {
+		pixels[i] = glm::vec3(data[i * 3 + 0], data[i * 3 + 1], data[i * 3 + 2]);
+	}
+	stbi_image_free(data);
+
+	// Set up environment & sampling tables
+	auto const buildStart = std::chrono::high_resolution_clock::now();
+	Environment environment(static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::move(pixels));
+	auto const buildEnd = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> const buildTime = buildEnd - buildStart;
+
+	printf("Parsed environment:\n");
+	printf("  Resolution:     %d x %d\n", width, height);
+	printf("  Table build:    %.3f ms\n", buildTime.count());
+	printf("  Memory usage:   %.3f MiB\n", static_cast<double>(environment.memoryUsage()) / (1024.0 * 1024.0));
+	return environment;
+}
+
+Environment Environment::fromColor(glm::vec3 const& color)
+{
+	return Environment(1, 1, { color });
+}
+
+glm::vec3 Environment::evaluate(glm::vec3 const& direction) const
+{
+	if (m_pixels.empty()) {
+		return glm::vec3(0.0F);
+	}
+
+	glm::vec2 const uv = directionToUV(direction);
+	uint32_t const x = glm::min(static_cast<uint32_t>(uv.x * static_cast<float>(m_width)), m_width - 1);
+	uint32_t const y = glm::min(static_cast<uint32_t>(uv.y * static_cast<float>(m_height)), m_height - 1);
+	return m_pixels[x + y * m_width];
+}
+
+glm::vec3 Environment::sample(Sampler& sampler, glm::vec3& direction, float& pdf) const
+{
+	pdf = 0.0F;
+	if (m_pixels.empty() || m_marginalIntegral <= 0.0F) {
+		return glm::vec3(0.0F);
+	}
+
+	// Sample row from marginal distribution, then column from row's conditional distribution
+	glm::vec2 const eta = sampler.sample2D();
+	float pdfV = 0.0F;
+	float pdfU = 0.0F;
+	uint32_t row = 0;
+	uint32_t column = 0;
+	float const v = sampleContinuous1D(m_marginalFunc.data(), m_marginalCDF.data(), m_height, m_marginalIntegral, eta.y, pdfV, row);
+	float const u = sampleContinuous1D(
+		&m_conditionalFunc[static_cast<size_t>(row) * m_width],
+		&m_conditionalCDF[static_cast<size_t>(row) * (m_width + 1)],
+		m_width, m_marginalFunc[row], eta.x, pdfU, column
+	);
+
+	// Convert UV PDF to solid angle PDF
+	direction = uvToDirection(glm::vec2(u, v));
+	float const sinTheta = glm::sin(v * PI);
+	if (sinTheta <= 0.0F) {
+		return glm::vec3(0.0F);
+	}
+
+	pdf = (pdfU * pdfV) / (2.0F * PI * PI * sinTheta);
+	return m_pixels[column + row * m_width];
+}
+
+float Environment::pdf(glm::vec3 const& direction) const
+{
+	if (m_pixels.empty() || m_marginalIntegral <= 0.0F) {
+		return 0.0F;
+	}
+
+	glm::vec2 const uv = directionToUV(direction);
+	float const sinTheta = glm::sin(uv.y * PI);
+	if (sinTheta <= 0.0F) {
+		return 0.0F;
+	}
+
+	// p(u, v) = p(u | v) * p(v) = f(u, v) / integral
+	uint32_t const x = glm::min(static_cast<uint32_t>(uv.x * static_cast<float>(m_width)), m_width - 1);
+	uint32_t const y = glm::min(static_cast<uint32_t>(uv.y * static_cast<float>(m_height)), m_height - 1);
+	float const pdfUV = m_conditionalFunc[x + static_cast<size_t>(y) * m_width] / m_marginalIntegral;
+	return pdfUV / (2.0F * PI * PI * sinTheta);
+}
+
+size_t Environment::memoryUsage() const
+{
+	return m_pixels.size() * sizeof(glm::vec3)
+		+ m_conditionalFunc.size() * sizeof(float)
+		+ m_conditionalCDF.size() * sizeof(float)
+		+ m_marginalFunc.size() * sizeof(float)
+		+ m_marginalCDF.size() * sizeof(float);
+}
+
+void Environment::buildSamplingTables()
+{
+	m_conditionalFunc.resize(static_cast<size_t>(m_width) * m_height);
+	m_conditionalCDF.resize(static_cast<size_t>(m_width + 1) * m_height);
+	m_marginalFunc.resize(m_height);
+	m_marginalCDF.resize(m_height + 1);
+
+	// Weight pixels by luminance & solid angle (rows near the poles cover less of the sphere)
+	for (uint32_t y = 0; y < m_height; y++)
+	{
+		float const sinTheta = glm::sin(PI * (static_cast<float>(y) + 0.5F) / static_cast<float>(m_height));
+		for (uint32_t x = 0; x < m_width; x++)
+		{
+			size_t const idx = x + static_cast<size_t>(y) * m_width;
+			m_conditionalFunc[idx] = glm::max(luma(m_pixels[idx]), 0.0F) * sinTheta;
+		}
+
+		m_marginalFunc[y] = buildCDF1D(
+			&m_conditionalFunc[static_cast<size_t>(y) * m_width],
+			m_width,
+			&m_conditionalCDF[static_cast<size_t>(y) * (m_width + 1)]
+		);
+	}
+
+	m_marginalIntegral = buildCDF1D(m_marginalFunc.data(), m_height, m_marginalCDF.data());
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "sampler.hpp"
+
+/// @brief The Environment stores an equirectangular (lat-long) radiance map surrounding the scene.
+/// Sampling tables are built on construction, allowing luminance-proportional importance sampling of the map.
+class Environment
+{
+public:
+	Environment() = default;
+
+	/// @brief Create an environment from raw equirectangular pixel data.
+	/// @param width
+	/// @param height
+	/// @param pixels Linear RGB radiance values, stored row by row starting at the top (+Y) of the sphere.
+	Environment(uint32_t width, uint32_t height, std::vector<glm::vec3> pixels);
+
+	/// @brief Load an environment from an HDR (or LDR) image file.
+	/// @param path
+	/// @return
+	static Environment fromFile(std::string const& path);
+
+	/// @brief Create a constant colored environment.
+	/// @param color
+	/// @return
+	static Environment fromColor(glm::vec3 const& color);
+
+	/// @brief Evaluate the environment radiance in a direction.
+	/// @param direction Normalized world space direction.
+	/// @return
+	glm::vec3 evaluate(glm::vec3 const& direction) const;
+
+	/// @brief Importance sample a direction on the environment.
+	/// @param sampler
+	/// @param direction Output parameter containing the sampled world space direction.
+	/// @param pdf Output parameter containing the solid angle PDF of the sampled direction.
+	/// @return The environment radiance in the sampled direction.
+	glm::vec3 sample(Sampler& sampler, glm::vec3& direction, float& pdf) const;
+
+	/// @brief Evaluate the solid angle PDF of sampling a direction.
+	/// @param direction
+	/// @return
+	float pdf(glm::vec3 const& direction) const;
+
+	/// @brief Get the size in bytes of the environment radiance data & sampling tables.
+	/// @return
+	size_t memoryUsage() const;
+
+private:
+	/// @brief Build the marginal & conditional CDFs used for sampling the environment.
+	void buildSamplingTables();
+
+private:
+	uint32_t				m_width					= 0;
+	uint32_t				m_height				= 0;
+	std::vector<glm::vec3>	m_pixels				= {};
+
+	// -- Sampling tables --
+	std::vector<float>		m_conditionalFunc		= {}; //< per pixel sampling weights (width * height)
+	std::vector<float>		m_conditionalCDF		= {}; //< per row CDFs ((width + 1) * height)
+	std::vector<float>		m_marginalFunc			= {}; //< per row weight integrals (height)
+	std::vector<float>		m_marginalCDF			= {}; //< CDF over rows (height + 1)
+	float					m_marginalIntegral		= 0.0F;
+};
@@ -0,0 +1,85 @@
+#include "film.hpp"
+
+#include <cassert>
+
+/// @brief Atomically add to a float value (std::atomic<float>::fetch_add is C++20).
+/// @param target 
+/// @param value 
+static void atomicAdd(std::atomic<float>& target, float value)
+{
+	float current = target.load(std::memory_order_relaxed);
+	while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+		//
+	}
+}
+
+SplatFilm::SplatFilm(uint32_t width, uint32_t height)
+	:
+	m_width(width),
+	m_height(height),
+	m_data(static_cast<size_t>(width) * height * 3)
+{
+	//
+}
+
+void SplatFilm::clear()
+{
+	for (std::atomic<float>& value : m_data) {
+		value.store(0.0F, std::memory_order_relaxed);
+	}
+}
+
+void SplatFilm::set(uint32_t x, uint32_t y, glm::vec3 const& value)
+{
+	size_t const idx = (x + static_cast<size_t>(y) * m_width) * 3;
+	m_data[idx + 0].store(value.r, std::memory_order_relaxed);
+	m_data[idx + 1].store(value.g, std::memory_order_relaxed);
+	m_data[idx + 2].store(value.b, std::memory_order_relaxed);
+}
+
+void SplatFilm::accumulate(SplatFilm const& film)
+{
+	assert(film.m_data.size() == m_data.size());
+	for (size_t i = 0; i < m_data.size(); i++) {
+		m_data[i].store(m_data[i].load(std::memory_order_relaxed) + film.m_data[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+void SplatFilm::splat(glm::vec2 const& uv, glm::vec3 const& value)
+{
+	if (uv.x < 0.0F || uv.x >= 1.0F || uv.y < 0.0F || uv.y >= 1.0F) {
+		return;
+	}
+
+	uint32_t const x = glm::min(static_cast<uint32_t>(uv.x * static_cast<float>(m_width)), m_width - 1);
+	uint32_t const y = glm::min(static_cast<uint32_t>(uv.y * static_cast<float>(m_height)), m_height - 1);
+	size_t const idx = (x + static_cast<size_t>(y) * m_width) * 3;
+
+	atomicAdd(m_data[idx + 0], value.r);
+	atomicAdd(m_data[idx + 1], value.g);
+	atomicAdd(m_data[idx + 2], value.b);
+}
+
+glm::vec3 SplatFilm::get(uint32_t x, uint32_t y) const
+{
+	size_t const idx = (x + static_cast<size_t>(y) * m_width) * 3;
+	return glm::vec3(
+		m_data[idx + 0].load(std::memory_order_relaxed),
+		m_data[idx + 1].load(std::memory_order_relaxed),
+		m_data[idx + 2].load(std::memory_order_relaxed)
+	);
+}
+
+void SplatBuffer::splat(glm::vec2 const& uv, glm::vec3 const& value)
+{
+	m_splats.push_back({ uv, value });
+}
+
+void SplatBuffer::commit(SplatFilm& film)
+{
+	for (Splat const& splat : m_splats) {
+		film.splat(splat.uv, splat.value);
+	}
+
+	m_splats.clear();
+}
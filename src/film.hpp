@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// @brief The SplatTarget interface receives contributions at arbitrary image positions from splatting integrators.
+class SplatTarget
+{
+public:
+	SplatTarget() = default;
+	virtual ~SplatTarget() = default;
+
+	SplatTarget(SplatTarget const&) = default;
+	SplatTarget& operator=(SplatTarget const&) = default;
+
+	/// @brief Add a contribution to the target.
+	/// @param uv Normalized [0, 1] image coordinates.
+	/// @param value
+	virtual void splat(glm::vec2 const& uv, glm::vec3 const& value) = 0;
+};
+
+/// @brief The SplatFilm accumulates contributions at arbitrary image positions, allowing concurrent splatting from multiple threads.
+class SplatFilm : public SplatTarget
+{
+public:
+	/// @brief Create a cleared splat film.
+	/// @param width 
+	/// @param height 
+	SplatFilm(uint32_t width, uint32_t height);
+
+	SplatFilm(SplatFilm const&) = delete;
+	SplatFilm& operator=(SplatFilm const&) = delete;
+
+	/// @brief Clear all accumulated contributions, must not be called concurrently with splat.
+	void clear();
+
+	/// @brief Overwrite the accumulated value of a pixel, used to restore checkpoints. Must not be called concurrently with splat.
+	/// @param x 
+	/// @param y 
+	/// @param value 
+	void set(uint32_t x, uint32_t y, glm::vec3 const& value);
+
+	/// @brief Add the accumulated values of a film with the same size. Must not be called concurrently with splat on either film.
+	/// @param film 
+	void accumulate(SplatFilm const& film);
+
+	/// @brief Atomically add a contribution to the film.
+	/// @param uv Normalized [0, 1] image coordinates.
+	/// @param value 
+	void splat(glm::vec2 const& uv, glm::vec3 const& value) override;
+
+	/// @brief Get the accumulated splat value for a pixel.
+	/// @param x 
+	/// @param y 
+	/// @return 
+	glm::vec3 get(uint32_t x, uint32_t y) const;
+
+private:
+	uint32_t						m_width		= 0;
+	uint32_t						m_height	= 0;
+	std::vector<std::atomic<float>>	m_data		= {}; //< RGB triplets per pixel
+};
+
+/// @brief The SplatBuffer records the contributions of a single worker & adds them to a film on commit,
+/// so the film only ever contains complete sets of light paths, e.g. those of finished pixels.
+class SplatBuffer : public SplatTarget
+{
+public:
+	/// @brief Record a contribution, not visible in the film until committed.
+	/// @param uv Normalized [0, 1] image coordinates.
+	/// @param value
+	void splat(glm::vec2 const& uv, glm::vec3 const& value) override;
+
+	/// @brief Add all recorded contributions to a film & clear the buffer.
+	/// @param film 
+	void commit(SplatFilm& film);
+
+private:
+	struct Splat
+	{
+		glm::vec2	uv;
+		glm::vec3	value;
+	};
+
+	std::vector<Splat>	m_splats	= {}; //< recorded since the last commit, capacity is kept between commits
+};
@@ -0,0 +1,66 @@
+#include "framebuffer.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+Framebuffer::Framebuffer(uint32_t width, uint32_t height, bool halfPrecision)
+	:
+	m_width(width),
+	m_height(height),
+	m_halfPrecision(halfPrecision)
+{
+	size_t const pixelCount = static_cast<size_t>(width) * height;
+	if (m_halfPrecision) {
+		m_halfPixels.resize(pixelCount * 3);
+	}
+	else {
+		m_pixels.resize(pixelCount);
+	}
+}
+
+void Framebuffer::store(uint32_t x, uint32_t y, glm::vec3 const& value)
+{
+	size_t const idx = x + static_cast<size_t>(y) * m_width;
+	if (m_halfPrecision)
+	{
+		m_halfPixels[idx * 3 + 0] = glm::packHalf1x16(value.r);
+		m_halfPixels[idx * 3 + 1] = glm::packHalf1x16(value.g);
+		m_halfPixels[idx * 3 + 2] = glm::packHalf1x16(value.b);
+	}
+	else
+	{
+		m_pixels[idx] = value;
+	}
+}
+
+glm::vec3 Framebuffer::load(uint32_t x, uint32_t y) const
+{
+	size_t const idx = x + static_cast<size_t>(y) * m_width;
+	if (m_halfPrecision)
+	{
+		return glm::vec3(
+			glm::unpackHalf1x16(m_halfPixels[idx * 3 + 0]),
+			glm::unpackHalf1x16(m_halfPixels[idx * 3 + 1]),
+			glm::unpackHalf1x16(m_halfPixels[idx * 3 + 2])
+		);
+	}
+
+	return m_pixels[idx];
+}
+
+size_t Framebuffer::memoryUsage() const
+{
+	return m_pixels.size() * sizeof(glm::vec3) + m_halfPixels.size() * sizeof(uint16_t);
+}
+
+uint32_t packPixelRGBA8(glm::vec3 const& color)
+{
+	// Do gamma conversion
+	glm::vec3 const gamma = glm::pow(color, glm::vec3(1.0F / 2.2F));
+
+	// Do byte packing
+	uint32_t const r = static_cast<uint32_t>(glm::clamp(gamma.r, 0.0F, 1.0F) * 255.99F) & 0xFF;
+	uint32_t const g = static_cast<uint32_t>(glm::clamp(gamma.g, 0.0F, 1.0F) * 255.99F) & 0xFF;
+	uint32_t const b = static_cast<uint32_t>(glm::clamp(gamma.b, 0.0F, 1.0F) * 255.99F) & 0xFF;
+	uint32_t const a = 0xFF;
+	return (a << 24) + (b << 16) + (g << 8) + r;
+}
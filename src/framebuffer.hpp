@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/// @brief The Framebuffer stores linear RGB pixel values in either full or half precision floats.
+class Framebuffer
+{
+public:
+	Framebuffer() = default;
+
+	/// @brief Create a cleared framebuffer.
+	/// @param width 
+	/// @param height 
+	/// @param halfPrecision Store pixels as half floats, reducing memory usage from 12 to 6 bytes per pixel.
+	Framebuffer(uint32_t width, uint32_t height, bool halfPrecision);
+
+	/// @brief Store a pixel value.
+	/// @param x 
+	/// @param y 
+	/// @param value 
+	void store(uint32_t x, uint32_t y, glm::vec3 const& value);
+
+	/// @brief Load a pixel value.
+	/// @param x 
+	/// @param y 
+	/// @return 
+	glm::vec3 load(uint32_t x, uint32_t y) const;
+
+	/// @brief Get the size in bytes of the pixel storage.
+	/// @return 
+	size_t memoryUsage() const;
+
+	uint32_t width() const { return m_width; }
+	uint32_t height() const { return m_height; }
+
+private:
+	uint32_t				m_width			= 0;
+	uint32_t				m_height		= 0;
+	bool					m_halfPrecision	= false;
+	std::vector<glm::vec3>	m_pixels		= {};
+	std::vector<uint16_t>	m_halfPixels	= {}; //< RGB half float triplets
+};
+
+/// @brief Convert a linear RGB color to a gamma corrected RGBA8 value (R in the lowest byte).
+/// @param color 
+/// @return 
+uint32_t packPixelRGBA8(glm::vec3 const& color);
@@ -1,160 +1,393 @@
 #include "integrator.hpp"
 
-#define TINYBVH_IMPLEMENTATION
-
 #include <cassert>
-#include <tiny_bvh.h>
 
 #include "brdf.hpp"
 
-#define DO_RUSSIAN_ROULETTE 1
+/// @brief Power heuristic for weighting two sampling strategies (Veach & Guibas).
+/// @param pdfA PDF of the strategy being weighted.
+/// @param pdfB PDF of the competing strategy.
+/// @return MIS weight for strategy A.
+static float powerHeuristic(float pdfA, float pdfB)
+{
+	float const a2 = pdfA * pdfA;
+	float const b2 = pdfB * pdfB;
+	return (a2 + b2) > 0.0F ? a2 / (a2 + b2) : 0.0F;
+}
 
-PathTracedIntegrator::PathTracedIntegrator(uint32_t maxBounceDepth)
-	:
-	m_maxBounceDepth(maxBounceDepth)
+/// @brief Check if a material is rough enough for view independent cached radiance.
+/// @param material 
+/// @return 
+static bool isRoughSurface(Material const& material)
 {
-	//
+	return material.roughness >= PathTracedIntegrator::CacheMinRoughness;
 }
 
-void PathTracedIntegrator::setSceneData(Scene const& scene)
+/// @brief Check if a material reflects close to diffusely, so cached radiance may replace the rest of a path.
+/// Metals & glossy dielectrics reflect view dependent radiance the cache does not store.
+/// @param material 
+/// @return 
+static bool isDiffuseSurface(Material const& material)
 {
-	assert(!scene.materials.empty());
-	assert(!scene.meshes.empty());
+	return material.metallic <= 0.0F && material.roughness >= PathTracedIntegrator::CacheTerminationMinRoughness;
+}
 
-	// Set scene
-	m_pScene = &scene;
+/// @brief Check if a material emits light.
+/// @param material 
+/// @return 
+static bool isEmissive(Material const& material)
+{
+	return material.emission.x > 0.0F || material.emission.y > 0.0F || material.emission.z > 0.0F;
+}
 
-	// Generate render instances
-	m_instances.clear();
-	for (auto const& object : scene.objects) {
-		m_instances.push_back(RenderInstance{ object.mesh, object.material });
-	}
+/// @brief Component-wise inverse, 0 for zero components.
+/// @param value 
+/// @return 
+static glm::vec3 safeInverse(glm::vec3 const& value)
+{
+	return {
+		value.x > 0.0F ? 1.0F / value.x : 0.0F,
+		value.y > 0.0F ? 1.0F / value.y : 0.0F,
+		value.z > 0.0F ? 1.0F / value.z : 0.0F,
+	};
+}
 
-	// Create BLASses for meshes in scene
-	m_blasses.clear();
-	m_blasses.reserve(scene.meshes.size());
-	for (auto const& mesh : scene.meshes)
-	{
-		tinybvh::bvhvec4slice vertices{};
-		vertices.data = reinterpret_cast<int8_t const*>(mesh.vertices.data());
-		vertices.stride = sizeof(Vertex);
-		vertices.count = static_cast<uint32_t>(mesh.vertices.size());
-
-		std::shared_ptr<tinybvh::BVH> blas = std::make_shared<tinybvh::BVH>();
-		blas->PrepareBuild(vertices, mesh.indices.data(), mesh.indices.size() / 3);
-		m_blasses.push_back(blas);
+void Integrator::traceBatch(Ray const* rays, size_t count, Sampler& sampler, TraceContext const& context, glm::vec3* radiance) const
+{
+	for (size_t i = 0; i < count; i++) {
+		radiance[i] = trace(rays[i], sampler, context);
 	}
+}
 
-	// Build all BLASses & store pointers for TLAS build
-	m_blasPointers.clear();
-	m_blasPointers.reserve(m_blasses.size());
-	for (auto const& blas : m_blasses)
-	{
-		blas->Build();
-		m_blasPointers.push_back(blas.get());
-	}
+PathTracedIntegrator::PathTracedIntegrator(uint32_t maxBounceDepth, TerminationPolicy const& terminationPolicy)
+	:
+	m_maxBounceDepth(maxBounceDepth),
+	m_terminationPolicy(terminationPolicy)
+{
+	//
+}
 
-	// Build TLAS using instances (just straight up using meshes at world origin for now)
-	m_blasInstances.clear();
-	m_blasInstances.reserve(m_instances.size());
-	for (auto const& instance : m_instances)
-	{
-		assert(instance.object < m_blasses.size());
-		tinybvh::BLASInstance blas(static_cast<uint32_t>(instance.object));
-		blas.aabbMin = m_blasses[instance.object]->aabbMin;
-		blas.aabbMax = m_blasses[instance.object]->aabbMax;
+void PathTracedIntegrator::setSceneData(Scene const& scene)
+{
+	// Set scene & build acceleration structures
+	m_pScene = &scene;
+	m_accel.build(scene);
 
-		m_blasInstances.push_back(blas);
+	// Gather emissive analytic primitives, emissive meshes are only reached by BRDF sampling
+	m_analyticLights.clear();
+	for (size_t i = 0; i < scene.primitives.size(); i++)
+	{
+		if (isEmissive(scene.materials[scene.primitives[i].material])) {
+			m_analyticLights.push_back(static_cast<uint32_t>(i));
+		}
 	}
-
-	m_tlas = std::make_unique<tinybvh::BVH>();
-	m_tlas->Build(m_blasInstances.data(), static_cast<uint32_t>(m_blasInstances.size()), m_blasPointers.data(), static_cast<uint32_t>(m_blasPointers.size()));
 }
 
-glm::vec3 PathTracedIntegrator::trace(Ray const& ray, Sampler& sampler) const
+glm::vec3 PathTracedIntegrator::trace(Ray const& ray, Sampler& sampler, TraceContext const& context) const
 {
 	assert(
 		m_pScene != nullptr
-		&& !m_blasses.empty()
-		&& m_tlas != nullptr
+		&& m_accel.isBuilt()
 		&& "Integrator needs scene data to be set"
 	);
 
-	// Set up ray state
-	glm::vec3 throughput{ 1.0F, 1.0F, 1.0F };
-	glm::vec3 energy{};
+	Environment const& environment = m_pScene->environment;
+	RenderCounters counters{};
+
+	// Analytic lights are chosen uniformly for next event estimation
+	uint32_t const analyticLightCount = static_cast<uint32_t>(m_analyticLights.size());
+	float const analyticLightChoicePDF = analyticLightCount > 0 ? 1.0F / static_cast<float>(analyticLightCount) : 0.0F;
+
+	// Radiance cache is filled during fill passes, otherwise it is used as adjoint estimate and/or to terminate paths
+	bool const fillCache = m_pRadianceCache != nullptr && context.fillRadianceCache;
+	bool const queryAdjoint = m_pRadianceCache != nullptr && !context.fillRadianceCache
+		&& m_terminationPolicy.mode == RouletteMode::Adjoint
+		&& luma(context.pixelEstimate) > 0.0F;
+	bool const terminateOnCache = m_pRadianceCache != nullptr && !context.fillRadianceCache && m_cacheTermination;
+
+	// Paths created by splitting are stored on a stack & traced after the current path terminates
+	struct PathState
+	{
+		tinybvh::Ray	ray;
+		glm::vec3		throughput;
+		float			brdfPDF;		//< PDF of the last BRDF sample, used for environment MIS
+		uint32_t		depth;
+		bool			isCameraRay;
+		bool			isDiffuseBounce;	//< last bounce left a diffuse surface, cached radiance may be used
+	};
 
-	// Set up tinybvh ray
-	tinybvh::Ray current({ ray.O.x, ray.O.y, ray.O.z }, { ray.D.x, ray.D.y, ray.D.z });
-	for (uint32_t i = 0; i < m_maxBounceDepth; i++) // max bounce depth is 7
+	// Rough path vertices recorded for cache filling, reflected radiance is accumulated as the path continues
+	struct CacheVertex
 	{
-		float const tMin = 1e-3F;
-		float const tMax = 1e30F;
-		
-		m_tlas->Intersect(current);
-		if (current.hit.t >= BVH_FAR) {
-			// Evaluate environment
-			// TODO(nemjit001): Evaluate environment color (HDRI, color, whatever)
-			energy += throughput * glm::vec3(0.3F, 0.6F, 0.9F); //< just some blue color
-			break;
+		glm::vec3	position;
+		glm::vec3	normal;
+		glm::vec3	invThroughput;	//< converts path contributions to radiance leaving the vertex
+		glm::vec3	radiance;
+	};
+
+	CacheVertex cacheVertices[MaxCacheVertices];
+	uint32_t cacheVertexCount = 0;
+
+	PathState pending[MaxPendingPaths];
+	uint32_t pendingCount = 0;
+	pending[pendingCount++] = PathState{
+		tinybvh::Ray({ ray.O.x, ray.O.y, ray.O.z }, { ray.D.x, ray.D.y, ray.D.z }),
+		glm::vec3(1.0F, 1.0F, 1.0F),
+		0.0F,
+		0,
+		true,
+		false,
+	};
+
+	glm::vec3 energy{};
+	auto const addEnergy = [&](glm::vec3 const& contribution) {
+		energy += contribution;
+		for (uint32_t k = 0; k < cacheVertexCount; k++) {
+			cacheVertices[k].radiance += contribution * cacheVertices[k].invThroughput;
 		}
-		else {
-			// Get hit geometry & material from scene
-			RenderInstance const& instance	= m_instances[current.hit.inst];
-			Mesh const& mesh				= m_pScene->meshes[instance.object];
-			Material const& material		= m_pScene->materials[instance.material];
-
-			// Get hit triangle from mesh
-			uint32_t const& idx = mesh.indices[current.hit.prim * 3];
-			Vertex const& v0 = mesh.vertices[idx + 0];
-			Vertex const& v1 = mesh.vertices[idx + 1];
-			Vertex const& v2 = mesh.vertices[idx + 2];
-
-			// Get ray direction
-			glm::vec3 const rayDirection = glm::vec3(current.D.x, current.D.y, current.D.z);
+	};
 
-			// Interpolate triangle data according to hit UV
-			glm::vec3 const barycentric	= { current.hit.u, current.hit.v, 1.0F - current.hit.u - current.hit.v };
-			glm::vec3 const position	= barycentric.x * v0.position + barycentric.y * v1.position + barycentric.z * v2.position;
-			glm::vec3 const normal		= glm::normalize(barycentric.x * v0.normal + barycentric.y * v1.normal + barycentric.z * v2.normal);
-			glm::vec3 const tangent		= glm::normalize(barycentric.x * v0.tangent + barycentric.y * v1.tangent + barycentric.z * v2.tangent);
+	while (pendingCount > 0)
+	{
+		// Set up ray state
+		PathState const path = pending[--pendingCount];
+		glm::vec3 throughput = path.throughput;
+		float brdfPDF = path.brdfPDF;
+		bool isCameraRay = path.isCameraRay;
+		bool isDiffuseBounce = path.isDiffuseBounce;
+		cacheVertexCount = 0;
 
-			// Set up TBN matrix for global/local frame conversion (also adjusts normal and tangent for backface hits)
-			bool const isBackfaceHit = glm::dot(rayDirection, normal) > 0.0F;
-			glm::vec3 const N = (isBackfaceHit ? -normal : normal);
-			glm::vec3 const _T = (isBackfaceHit ? -tangent : tangent);
-			glm::vec3 const T = glm::normalize(_T - glm::dot(_T, N) * N);
-			glm::vec3 const B = glm::normalize(glm::cross(N, T));
+		tinybvh::Ray current = path.ray;
+		for (uint32_t i = path.depth; i < m_maxBounceDepth; i++)
+		{
+			float const tMin = 1e-3F;
+
+			counters.rayCount++;
+			if (!m_accel.intersect(current)) {
+				// Evaluate environment, weighting BRDF sampled hits against environment sampling
+				glm::vec3 const direction = glm::vec3(current.D.x, current.D.y, current.D.z);
+				float const MISWeight = isCameraRay ? 1.0F : powerHeuristic(brdfPDF, environment.pdf(direction));
+				addEnergy(throughput * environment.evaluate(direction) * MISWeight);
+				break;
+			}
+
+			// Get hit surface data from scene
+			SurfaceInteraction const surface = m_accel.getSurfaceInteraction(current);
+			Material const& material = *surface.material;
+			glm::vec3 const rayDirection = glm::vec3(current.D.x, current.D.y, current.D.z);
+			glm::vec3 const& position = surface.position;
+			glm::vec3 const& N = surface.normal;
 
-			glm::mat3 const TBN(T, B, N);
+			// Set up TBN matrix for global/local frame conversion
+			glm::mat3 const& TBN = surface.TBN;
 			glm::mat3 const iTBN(glm::transpose(TBN));
 
-			// Shade hitpoint
-			if (material.emission.x > 0.0F || material.emission.y > 0.0F || material.emission.z > 0.0F) {
-				energy += throughput * material.emission;
+			// Shade hitpoint, analytic emitters hit by BRDF sampling are weighted against light sampling
+			if (isEmissive(material))
+			{
+				float MISWeight = 1.0F;
+				if (surface.isAnalytic && !isCameraRay)
+				{
+					glm::vec3 const origin = glm::vec3(current.O.x, current.O.y, current.O.z);
+					float const lightPDF = analyticLightChoicePDF * m_pScene->primitives[surface.primitive].solidAnglePDF(origin, rayDirection);
+					MISWeight = powerHeuristic(brdfPDF, lightPDF);
+				}
+
+				addEnergy(throughput * material.emission * MISWeight);
+			}
+
+			// Terminate paths at diffuse vertices reached through a diffuse bounce using cached reflected radiance
+			bool const isRough = isRoughSurface(material);
+			bool const isDiffuse = isDiffuseSurface(material);
+			if (terminateOnCache && isDiffuse && isDiffuseBounce)
+			{
+				glm::vec3 cachedRadiance{};
+				counters.cacheQueryCount++;
+				if (m_pRadianceCache->query(position, N, cachedRadiance))
+				{
+					counters.cacheHitCount++;
+					addEnergy(throughput * cachedRadiance);
+					break;
+				}
+			}
+
+			if (fillCache && isRough && cacheVertexCount < MaxCacheVertices) {
+				cacheVertices[cacheVertexCount++] = CacheVertex{ position, N, safeInverse(throughput), glm::vec3(0.0F) };
 			}
 
 			glm::vec3 const shadingNormal = iTBN * N;
 			glm::vec3 const wi = iTBN * -rayDirection;
+
+			// Sample environment (next event estimation), weighting against BRDF sampling
+			glm::vec3 lightDirection;
+			float lightPDF = 0.0F;
+			glm::vec3 const lightRadiance = environment.sample(sampler, lightDirection, lightPDF);
+			if (lightPDF > 0.0F)
+			{
+				float lightBRDFPDF = 0.0F;
+				glm::vec3 const brdf = evaluateDisneyBRDF(material, wi, shadingNormal, iTBN * lightDirection, lightBRDFPDF);
+				if (lightBRDFPDF > 0.0F)
+				{
+					glm::vec3 const shadowOrigin = position + lightDirection * tMin;
+					tinybvh::Ray const shadowRay({ shadowOrigin.x, shadowOrigin.y, shadowOrigin.z }, { lightDirection.x, lightDirection.y, lightDirection.z });
+
+					counters.rayCount++;
+					if (!m_accel.isOccluded(shadowRay)) {
+						addEnergy(throughput * brdf * lightRadiance * (powerHeuristic(lightPDF, lightBRDFPDF) / lightPDF));
+					}
+				}
+			}
+
+			// Sample an analytic light by solid angle (next event estimation), weighting against BRDF sampling
+			if (analyticLightCount > 0)
+			{
+				uint32_t const lightIdx = glm::min(static_cast<uint32_t>(sampler.sample() * static_cast<float>(analyticLightCount)), analyticLightCount - 1);
+				AnalyticPrimitive const& light = m_pScene->primitives[m_analyticLights[lightIdx]];
+
+				glm::vec3 analyticDirection{};
+				float analyticDistance = 0.0F;
+				float analyticPDF = 0.0F;
+				if (light.sampleSolidAngle(position, sampler, analyticDirection, analyticDistance, analyticPDF) && analyticPDF > 0.0F && analyticDistance > 2.0F * tMin)
+				{
+					analyticPDF *= analyticLightChoicePDF;
+
+					float analyticBRDFPDF = 0.0F;
+					glm::vec3 const brdf = evaluateDisneyBRDF(material, wi, shadingNormal, iTBN * analyticDirection, analyticBRDFPDF);
+					if (analyticBRDFPDF > 0.0F)
+					{
+						// Stop short of the sampled point so the light itself does not occlude the shadow ray
+						glm::vec3 const shadowOrigin = position + analyticDirection * tMin;
+						tinybvh::Ray const shadowRay(
+							{ shadowOrigin.x, shadowOrigin.y, shadowOrigin.z },
+							{ analyticDirection.x, analyticDirection.y, analyticDirection.z },
+							analyticDistance - 2.0F * tMin
+						);
+
+						counters.rayCount++;
+						if (!m_accel.isOccluded(shadowRay)) {
+							Material const& lightMaterial = m_pScene->materials[light.material];
+							addEnergy(throughput * brdf * lightMaterial.emission * (powerHeuristic(analyticPDF, analyticBRDFPDF) / analyticPDF));
+						}
+					}
+				}
+			}
+
+			// Adjoint-driven roulette & splitting is decided at the vertex, before sampling outgoing directions.
+			// The adjoint is the radiance leaving the vertex, estimated by the radiance cache (only valid for rough surfaces),
+			// vertices without an estimate use throughput roulette after sampling like RouletteMode::Throughput.
+			glm::vec3 adjoint{};
+			bool hasAdjoint = false;
+			if (queryAdjoint && isRough)
+			{
+				counters.cacheQueryCount++;
+				hasAdjoint = m_pRadianceCache->query(position, N, adjoint) && luma(adjoint) > 0.0F;
+				counters.cacheHitCount += hasAdjoint ? 1 : 0;
+			}
+
+			uint32_t pathCount = 1;
+			if (hasAdjoint)
+			{
+				pathCount = evaluateTermination(sampler, context, throughput, luma(adjoint), MaxPendingPaths - pendingCount + 1);
+				if (pathCount == 0) {
+					break;
+				}
+			}
+
+			// Queue split paths, each with an independently sampled direction
+			for (uint32_t split = 1; split < pathCount; split++)
+			{
+				glm::vec3 splitwo;
+				float splitPDF = 0.0F;
+				glm::vec3 const splitThroughput = throughput * sampleDisneyBRDF(sampler, material, wi, shadingNormal, splitwo, splitPDF);
+
+				glm::vec3 const D = TBN * splitwo;
+				glm::vec3 const O = glm::vec3(position) + D * tMin;
+				pending[pendingCount++] = PathState{
+					tinybvh::Ray({ O.x, O.y, O.z }, { D.x, D.y, D.z }),
+					splitThroughput,
+					splitPDF,
+					i + 1,
+					false,
+					isDiffuse,
+				};
+			}
+
 			glm::vec3 wo;
-			throughput *= sampleDisneyBRDF(sampler, material, wi, shadingNormal, wo);
+			throughput *= sampleDisneyBRDF(sampler, material, wi, shadingNormal, wo, brdfPDF);
+			isCameraRay = false;
+			isDiffuseBounce = isDiffuse;
 
 			// Set up outgoing ray
 			glm::vec3 const D = TBN * wo;
 			glm::vec3 const O = glm::vec3(position) + D * tMin; // avoid self intersections by offsetting ray a small amount
 			current = tinybvh::Ray({ O.x, O.y, O.z }, { D.x, D.y, D.z });
-			
-#if			DO_RUSSIAN_ROULETTE
-			// Do russian roulette (terminate if throughput has low contribution)
-			float const p = glm::clamp(glm::max(throughput.r, glm::max(throughput.g, throughput.b)), 0.0F, 1.0F);
-			if (p < sampler.sample()) {
-				break;
+
+			if (m_terminationPolicy.mode == RouletteMode::Throughput
+				|| (m_terminationPolicy.mode == RouletteMode::Adjoint && !hasAdjoint))
+			{
+				// Do russian roulette (terminate if throughput has low contribution)
+				float const p = glm::clamp(glm::max(throughput.r, glm::max(throughput.g, throughput.b)), 0.0F, 1.0F);
+				if (p < sampler.sample()) {
+					break;
+				}
+
+				throughput /= p;
 			}
+		}
 
-			throughput /= p;
-#endif		// DO_RUSSIAN_ROULETTE
+		// Store reflected radiance estimates of this path in the cache
+		for (uint32_t k = 0; k < cacheVertexCount; k++) {
+			m_pRadianceCache->insert(cacheVertices[k].position, cacheVertices[k].normal, cacheVertices[k].radiance);
 		}
 	}
 
+	if (context.counters != nullptr) {
+		*context.counters += counters;
+	}
+
 	return energy;
 }
+
+void PathTracedIntegrator::traceBatch(Ray const* rays, size_t count, Sampler& sampler, TraceContext const& context, glm::vec3* radiance) const
+{
+	// Qualified calls are resolved statically, avoiding a virtual call per ray
+	for (size_t i = 0; i < count; i++) {
+		radiance[i] = PathTracedIntegrator::trace(rays[i], sampler, context);
+	}
+}
+
+uint32_t PathTracedIntegrator::evaluateTermination(Sampler& sampler, TraceContext const& context, glm::vec3& throughput, float adjoint, uint32_t maxSplits) const
+{
+	// Weight window centered on the throughput for which the expected path contribution (throughput * adjoint)
+	// equals the pixel estimate
+	float const windowCenter = luma(context.pixelEstimate) / adjoint;
+	float const lowerBound = (2.0F * windowCenter) / (1.0F + m_terminationPolicy.windowSize);
+	float const upperBound = lowerBound * m_terminationPolicy.windowSize;
+
+	float const weight = luma(throughput);
+	if (weight < lowerBound)
+	{
+		// Russian roulette, survivors are boosted to the lower window bound
+		float const survivalProbability = weight / lowerBound;
+		if (survivalProbability < sampler.sample()) {
+			return 0;
+		}
+
+		throughput /= survivalProbability;
+		return 1;
+	}
+
+	if (weight > upperBound)
+	{
+		// Split path into multiple paths, each carrying an equal share of the throughput
+		uint32_t const splitCount = glm::clamp(
+			static_cast<uint32_t>(glm::ceil(weight / upperBound)),
+			1U, glm::max(glm::min(m_terminationPolicy.maxSplitFactor, maxSplits), 1U)
+		);
+
+		throughput /= static_cast<float>(splitCount);
+		return splitCount;
+	}
+
+	return 1;
+}
@@ -1,12 +1,61 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <tiny_bvh.h>
+#include <vector>
 
+#include "accel.hpp"
+#include "cache.hpp"
+#include "camera.hpp"
+#include "film.hpp"
 #include "ray.hpp"
 #include "sampler.hpp"
 #include "scene.hpp"
 
+/// @brief Render work counters, accumulated per worker & summed after rendering.
+struct RenderCounters
+{
+	uint64_t	rayCount		= 0;	//< rays cast into the scene
+	uint64_t	cacheQueryCount	= 0;	//< radiance cache lookups
+	uint64_t	cacheHitCount	= 0;	//< radiance cache lookups that terminated a path
+
+	RenderCounters& operator+=(RenderCounters const& other)
+	{
+		rayCount += other.rayCount;
+		cacheQueryCount += other.cacheQueryCount;
+		cacheHitCount += other.cacheHitCount;
+		return *this;
+	}
+};
+
+/// @brief Per-sample render state passed to integrators by the renderer.
+struct TraceContext
+{
+	Camera const*		camera				= nullptr;	//< camera used to generate the traced ray
+	SplatTarget*		film				= nullptr;	//< target for contributions to arbitrary pixels, null if splatted contributions are not needed
+	glm::vec3			pixelEstimate		= {};		//< running radiance estimate of the traced pixel, zero if unknown
+	RenderCounters*		counters			= nullptr;	//< incremented for traced work if set
+	bool				fillRadianceCache	= false;	//< store path radiance in the integrator radiance cache instead of querying it
+};
+
+/// @brief Path termination strategies.
+enum class RouletteMode
+{
+	None,		//< only terminate paths at the max bounce depth
+	Throughput,	//< russian roulette based on max path throughput
+	Adjoint,	//< adjoint-driven russian roulette & splitting (Adjoint-Driven Russian Roulette and Splitting in Light Transport Simulation, Vorba & Krivanek),
+				//< uses the radiance cache as adjoint estimate & falls back to throughput roulette where no cached radiance is available
+};
+
+/// @brief Runtime path termination & splitting settings.
+struct TerminationPolicy
+{
+	RouletteMode	mode			= RouletteMode::Throughput;
+	float			windowSize		= 5.0F;	//< ratio between the upper & lower weight window bounds
+	uint32_t		maxSplitFactor	= 4;	//< max number of paths a single path is split into per vertex
+};
+
 /// @brief The Integrator class can be used to sample scenes using different rendering equation integration algorithms.
 class Integrator
 {
@@ -21,11 +70,38 @@ public:
 	/// @param scene 
 	virtual void setSceneData(Scene const& scene) = 0;
 
+	/// @brief Get the integrator scene data.
+	/// @return The scene, nullptr if no scene data was set.
+	virtual Scene const* getSceneData() const = 0;
+
+	/// @brief Create a copy of the integrator with the same settings & scene data.
+	/// Scene data of the copy can be replaced through setSceneData, e.g. to place it in node-local memory.
+	/// @return 
+	virtual std::unique_ptr<Integrator> clone() const = 0;
+
 	/// @brief Trace a ray through the integrator scene.
 	/// @param ray Ray to trace.
 	/// @param sampler Sampler to use for random sampling during integration.
+	/// @param context Render state for the traced sample.
 	/// @return An RGB color sample for the scene.
-	virtual glm::vec3 trace(Ray const& ray, Sampler& sampler) const = 0;
+	virtual glm::vec3 trace(Ray const& ray, Sampler& sampler, TraceContext const& context) const = 0;
+
+	/// @brief Trace an array of rays through the integrator scene.
+	/// The default implementation calls trace per ray, integrators override it to avoid virtual calls per ray.
+	/// @param rays Rays to trace.
+	/// @param count 
+	/// @param sampler Sampler to use for random sampling during integration.
+	/// @param context Render state shared by all rays.
+	/// @param radiance Output array of count RGB color samples.
+	virtual void traceBatch(Ray const* rays, size_t count, Sampler& sampler, TraceContext const& context, glm::vec3* radiance) const;
+
+	/// @brief Get the acceleration structures built for the integrator scene.
+	/// @return 
+	virtual AccelerationStructure const& getAccelerationStructure() const = 0;
+
+	/// @brief Check if the integrator splats contributions to the context film.
+	/// @return 
+	virtual bool usesSplatting() const { return false; }
 };
 
 /// @brief The PathTracedIntegrator used one-directional path tracing to integrate a scene.
@@ -33,7 +109,7 @@ class PathTracedIntegrator : public Integrator
 {
 public:
 	PathTracedIntegrator() = default;
-	PathTracedIntegrator(uint32_t maxBounceDepth);
+	PathTracedIntegrator(uint32_t maxBounceDepth, TerminationPolicy const& terminationPolicy = {});
 	~PathTracedIntegrator() = default;
 
 	PathTracedIntegrator(PathTracedIntegrator const&) = default;
@@ -41,25 +117,58 @@ public:
 
 	void setSceneData(Scene const& scene) override;
 
-	glm::vec3 trace(Ray const& ray, Sampler& sampler) const override;
+	Scene const* getSceneData() const override { return m_pScene; }
+
+	std::unique_ptr<Integrator> clone() const override { return std::make_unique<PathTracedIntegrator>(*this); }
+
+	glm::vec3 trace(Ray const& ray, Sampler& sampler, TraceContext const& context) const override;
+
+	void traceBatch(Ray const* rays, size_t count, Sampler& sampler, TraceContext const& context, glm::vec3* radiance) const override;
+
+	AccelerationStructure const& getAccelerationStructure() const override { return m_accel; }
+
+	/// @brief Set the radiance cache, used as adjoint estimate for adjoint-driven roulette & optionally to terminate paths early.
+	/// The cache must outlive the integrator. Clones share the cache, so NUMA node replicas all access one instance.
+	/// @param cache Radiance cache, nullptr to disable caching.
+	/// @param terminatePaths Terminate paths reaching a diffuse surface through a diffuse bounce with the cached radiance,
+	///		trading bias for shorter paths. Without it the cache is only used as adjoint estimate.
+	void setRadianceCache(RadianceCache* cache, bool terminatePaths) { m_pRadianceCache = cache; m_cacheTermination = terminatePaths; }
+
+public:
+	/// @brief Max number of pending split paths per traced ray.
+	static constexpr uint32_t MaxPendingPaths = 64;
+
+	/// @brief Max number of vertices per path recorded for radiance cache filling.
+	static constexpr uint32_t MaxCacheVertices = 32;
+
+	/// @brief Min material roughness for surfaces using cached radiance as adjoint estimate.
+	static constexpr float CacheMinRoughness = 0.3F;
+
+	/// @brief Min material roughness for non-metallic surfaces terminating paths with cached radiance.
+	static constexpr float CacheTerminationMinRoughness = 0.8F;
 
 private:
-	struct RenderInstance
-	{
-		uint32_t object;
-		uint32_t material;
-	};
+	/// @brief Evaluate the termination policy at a path vertex.
+	/// The weight window is centered on the pixel estimate divided by the cached radiance leaving the vertex,
+	/// so paths are kept near their expected contribution to the pixel.
+	/// @param sampler 
+	/// @param context 
+	/// @param throughput Path throughput up to the vertex, adjusted for roulette survival or split count.
+	/// @param adjoint Luminance of the cached radiance leaving the vertex, must be positive.
+	/// @param maxSplits Max number of paths the current path may be split into.
+	/// @return The number of paths to continue with, 0 if the path is terminated.
+	uint32_t evaluateTermination(Sampler& sampler, TraceContext const& context, glm::vec3& throughput, float adjoint, uint32_t maxSplits) const;
 
 private:
-	uint32_t									m_maxBounceDepth	= 5;
-	Scene const*								m_pScene			= nullptr;
+	uint32_t				m_maxBounceDepth	= 5;
+	TerminationPolicy		m_terminationPolicy	= {};
+	Scene const*			m_pScene			= nullptr;
+	RadianceCache*			m_pRadianceCache	= nullptr; //< not owned, shared by clones
+	bool					m_cacheTermination	= false;
 
-	// -- Scene Data --
-	std::vector<RenderInstance>					m_instances			= {};
+	// -- Lights --
+	std::vector<uint32_t>	m_analyticLights	= {}; //< emissive scene primitives, sampled by solid angle for next event estimation
 
 	// -- Acceleration Structures --
-	std::vector<std::shared_ptr<tinybvh::BVH>>	m_blasses			= {};
-	std::vector<tinybvh::BVHBase*>				m_blasPointers		= {}; //< required for tinybvh blas instancing :/
-	std::vector<tinybvh::BLASInstance>			m_blasInstances		= {};
-	std::shared_ptr<tinybvh::BVH>				m_tlas				= {};
+	AccelerationStructure	m_accel				= {};
 };
@@ -1,10 +1,71 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 
+#include "bdpt.hpp"
+#include "cache.hpp"
 #include "camera.hpp"
+#include "checkpoint.hpp"
 #include "integrator.hpp"
+#include "preview.hpp"
+#include "primitive.hpp"
 #include "renderer.hpp"
 #include "scene.hpp"
 
+/// @brief Add a metal sphere, a sphere light, a glossy disk & a quad light to the scene.
+/// @param scene 
+/// @param tessellate Add the shapes as triangle meshes instead of analytic primitives, used to compare memory & traversal cost.
+static void addDemoPrimitives(Scene& scene, bool tessellate)
+{
+	uint32_t const materialOffset = static_cast<uint32_t>(scene.materials.size());
+
+	Material metal{};
+	metal.name = "AnalyticMetal";
+	metal.baseColor = { 0.9F, 0.8F, 0.6F };
+	metal.metallic = 1.0F;
+	metal.roughness = 0.1F;
+
+	Material glossy{};
+	glossy.name = "AnalyticGlossy";
+	glossy.baseColor = { 0.2F, 0.3F, 0.8F };
+	glossy.roughness = 0.3F;
+
+	Material warmLight{};
+	warmLight.name = "AnalyticWarmLight";
+	warmLight.baseColor = { 0.0F, 0.0F, 0.0F };
+	warmLight.emission = { 8.0F, 6.0F, 4.0F };
+
+	Material coolLight{};
+	coolLight.name = "AnalyticCoolLight";
+	coolLight.baseColor = { 0.0F, 0.0F, 0.0F };
+	coolLight.emission = { 4.0F, 4.0F, 6.0F };
+
+	scene.materials.push_back(metal);
+	scene.materials.push_back(glossy);
+	scene.materials.push_back(warmLight);
+	scene.materials.push_back(coolLight);
+
+	AnalyticPrimitive const primitives[] = {
+		AnalyticPrimitive::sphere({ 0.44F, 0.95F, 0.05F }, 0.2F, materialOffset + 0),
+		AnalyticPrimitive::sphere({ -0.5F, 1.5F, 0.3F }, 0.05F, materialOffset + 2),
+		AnalyticPrimitive::disk({ 0.0F, 1.1F, -0.99F }, { 0.0F, 0.0F, 1.0F }, 0.25F, materialOffset + 1),
+		AnalyticPrimitive::quad({ -0.8F, 1.9F, -0.8F }, { 0.2F, 0.0F, 0.0F }, { 0.0F, 0.0F, 0.2F }, materialOffset + 3),
+	};
+
+	for (auto const& primitive : primitives)
+	{
+		if (!tessellate)
+		{
+			scene.primitives.push_back(primitive);
+			continue;
+		}
+
+		scene.objects.push_back(SceneObject{ static_cast<uint32_t>(scene.meshes.size()), primitive.material });
+		scene.meshes.push_back(primitive.tessellate(64 /* segments */));
+	}
+}
+
 int main(int argc, char **argv)
 {
 	// Dump CLI args
@@ -12,18 +73,144 @@ int main(int argc, char **argv)
 		printf("arg %d: %s\n", i, argv[i]);
 	}
 
+	// Parse CLI args
+	char const* environmentPath = nullptr;
+	bool useBidirectional = false;
+	bool streaming = false;
+	bool halfPrecision = false;
+	bool preview = false;
+	bool cacheTermination = false;
+	bool numaAware = false;
+	bool numaReplication = true;
+	char const* primitiveMode = nullptr;
+	double checkpointInterval = 0.0;
+	bool resume = false;
+	TerminationPolicy terminationPolicy{};
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--environment") == 0 && i + 1 < argc) {
+			environmentPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--integrator") == 0 && i + 1 < argc)
+		{
+			char const* mode = argv[++i];
+			if (strcmp(mode, "bdpt") != 0 && strcmp(mode, "pt") != 0)
+			{
+				printf("Unknown integrator %s, expected pt|bdpt\n", mode);
+				return 1;
+			}
+
+			useBidirectional = strcmp(mode, "bdpt") == 0;
+		}
+		else if (strcmp(argv[i], "--streaming") == 0) {
+			streaming = true;
+		}
+		else if (strcmp(argv[i], "--half") == 0) {
+			halfPrecision = true;
+		}
+		else if (strcmp(argv[i], "--preview") == 0) {
+			preview = true;
+		}
+		else if (strcmp(argv[i], "--cache") == 0) {
+			cacheTermination = true;
+		}
+		else if (strcmp(argv[i], "--numa") == 0 && i + 1 < argc)
+		{
+			// NUMA placement with (replicate) or without (shared) node-local scene replicas
+			char const* mode = argv[++i];
+			if (strcmp(mode, "off") != 0 && strcmp(mode, "shared") != 0 && strcmp(mode, "replicate") != 0)
+			{
+				printf("Unknown NUMA mode %s, expected off|shared|replicate\n", mode);
+				return 1;
+			}
+
+			numaAware = strcmp(mode, "off") != 0;
+			numaReplication = strcmp(mode, "shared") != 0;
+		}
+		else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+			checkpointInterval = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--resume") == 0) {
+			resume = true;
+		}
+		else if (strcmp(argv[i], "--primitives") == 0 && i + 1 < argc)
+		{
+			primitiveMode = argv[++i];
+			if (strcmp(primitiveMode, "analytic") != 0 && strcmp(primitiveMode, "tessellated") != 0)
+			{
+				printf("Unknown primitive mode %s, expected analytic|tessellated\n", primitiveMode);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--roulette") == 0 && i + 1 < argc)
+		{
+			char const* mode = argv[++i];
+			if (strcmp(mode, "none") == 0) {
+				terminationPolicy.mode = RouletteMode::None;
+			}
+			else if (strcmp(mode, "adrrs") == 0) {
+				terminationPolicy.mode = RouletteMode::Adjoint;
+			}
+			else if (strcmp(mode, "throughput") == 0) {
+				terminationPolicy.mode = RouletteMode::Throughput;
+			}
+			else
+			{
+				printf("Unknown roulette mode %s, expected none|throughput|adrrs\n", mode);
+				return 1;
+			}
+		}
+	}
+
 	// Set up default config
 	// FIXME(nemjit001): load this from either CLI args or scene format
+	char const* scenePath = "./assets/CornellBox.obj";
+	uint32_t const maxDepth = 10; //< max bounce depth
 	RendererConfig config{};
-	config.filename = "render.png";
+	config.filename = streaming ? "render.ppm" : "render.png";
 	config.resolutionX = 1024;
 	config.resolutionY = 1024;
 	config.sampleCount = 128;
+	config.tileSize = 64;
+	config.streaming = streaming;
+	config.halfPrecision = halfPrecision;
+	config.numaAware = numaAware;
+	config.numaReplication = numaReplication;
+	config.cacheFillSamples = (!useBidirectional && (cacheTermination || terminationPolicy.mode == RouletteMode::Adjoint)) ? 4 : 0;
+	config.resume = resume;
+	if (checkpointInterval > 0.0 || resume)
+	{
+		// Resuming keeps checkpointing, so a render can be interrupted more than once
+		config.checkpointPath = config.filename + ".checkpoint";
+		config.checkpointInterval = checkpointInterval > 0.0 ? checkpointInterval : 60.0;
+
+		// Fingerprint the settings outside the render config that change pixel values, a checkpoint of another setup is not resumed
+		char description[1024];
+		snprintf(description, sizeof(description), "scene=%s environment=%s primitives=%s integrator=%s depth=%u roulette=%u window=%g split=%u cache=%d fill=%u",
+			scenePath,
+			environmentPath != nullptr ? environmentPath : "none",
+			primitiveMode != nullptr ? primitiveMode : "none",
+			useBidirectional ? "bdpt" : "pt",
+			maxDepth,
+			static_cast<uint32_t>(terminationPolicy.mode),
+			static_cast<double>(terminationPolicy.windowSize),
+			terminationPolicy.maxSplitFactor,
+			cacheTermination ? 1 : 0,
+			config.cacheFillSamples
+		);
+		config.sceneFingerprint = hashFingerprint(description, strlen(description));
+	}
 
 	printf("Render config\n");
 	printf("  Resolution X: %u\n", config.resolutionX);
 	printf("  Resolution Y: %u\n", config.resolutionY);
 	printf("  Sample count: %u\n", config.sampleCount);
+	printf("  Tile size:    %u\n", config.tileSize);
+	printf("  Streaming:    %s\n", config.streaming ? "yes" : "no");
+	printf("  Half floats:  %s\n", config.halfPrecision ? "yes" : "no");
+	printf("  NUMA:         %s\n", !config.numaAware ? "off" : (config.numaReplication ? "replicate" : "shared"));
+	printf("  Cache fill:   %u spp\n", config.cacheFillSamples);
+	printf("  Checkpoints:  %s\n", config.checkpointPath.empty() ? "off" : config.checkpointPath.c_str());
 	printf("  Output file:  %s\n", config.filename.c_str());
 
 	// Set up camera
@@ -35,13 +222,85 @@ int main(int argc, char **argv)
 	camera.forward = { 0.0F, 0.0F, -1.0F };
 
 	// Set up scene
-	Scene scene = Scene::fromFile("./assets/CornellBox.obj");
+	Scene scene = Scene::fromFile(scenePath);
+	if (environmentPath != nullptr) {
+		scene.environment = Environment::fromFile(environmentPath);
+	}
+
+	// Add demo shapes, either intersected analytically or tessellated into meshes
+	if (primitiveMode != nullptr) {
+		addDemoPrimitives(scene, strcmp(primitiveMode, "tessellated") == 0);
+	}
+
+	// Set up radiance cache, used by the path traced integrator as adjoint estimate for adjoint-driven roulette
+	// and to terminate paths if requested
+	std::unique_ptr<RadianceCache> cache{};
+	if (config.cacheFillSamples > 0)
+	{
+		cache = std::make_unique<RadianceCache>(0.05F /* cell size */, 1U << 18 /* cell count */);
+		printf("Radiance cache: %zu cells, %.3f MiB\n", cache->cellCount(), static_cast<double>(cache->memoryUsage()) / (1024.0 * 1024.0));
+	}
 
 	// Set up integrator
-	PathTracedIntegrator integrator(10 /* max bounce depth */);
-	integrator.setSceneData(scene);
+	std::unique_ptr<Integrator> integrator{};
+	if (useBidirectional) {
+		integrator = std::make_unique<BidirectionalIntegrator>(maxDepth);
+	}
+	else {
+		std::unique_ptr<PathTracedIntegrator> pathTracer = std::make_unique<PathTracedIntegrator>(maxDepth, terminationPolicy);
+		pathTracer->setRadianceCache(cache.get(), cacheTermination);
+		integrator = std::move(pathTracer);
+	}
+	integrator->setSceneData(scene);
+
+	AccelerationStructure const& accel = integrator->getAccelerationStructure();
+	printf("Scene geometry\n");
+	printf("  Meshes:       %zu\n", scene.meshes.size());
+	printf("  Primitives:   %zu\n", scene.primitives.size());
+	printf("  Geometry:     %.3f MiB\n", static_cast<double>(accel.geometryMemoryUsage()) / (1024.0 * 1024.0));
+	printf("  BVH:          %.3f MiB\n", static_cast<double>(accel.memoryUsage()) / (1024.0 * 1024.0));
+
+	if (preview)
+	{
+		// Progressive preview, camera moves are read from stdin until EOF or "quit"
+		PreviewConfig previewConfig{};
+		previewConfig.resolutionX = config.resolutionX;
+		previewConfig.resolutionY = config.resolutionY;
+		previewConfig.sampleCount = config.sampleCount;
+
+		PreviewRenderer previewRenderer(previewConfig, *integrator);
+		previewRenderer.start(camera);
+		printf("Preview running, enter \"move <x> <y> <z>\" to move the camera or \"quit\" to stop\n");
+
+		char line[256];
+		bool quit = false;
+		while (!quit && fgets(line, sizeof(line), stdin) != nullptr)
+		{
+			glm::vec3 offset{};
+			if (sscanf(line, "move %f %f %f", &offset.x, &offset.y, &offset.z) == 3)
+			{
+				Camera moved = previewRenderer.getCamera();
+				moved.position += offset;
+				previewRenderer.setCamera(moved);
+			}
+			else if (strncmp(line, "quit", 4) == 0) {
+				quit = true;
+			}
+		}
+
+		if (!quit) {
+			previewRenderer.wait();
+		}
+
+		previewRenderer.stop();
+		return 0;
+	}
 
 	// Render scene
-	Renderer().render(config, camera, integrator);
+	Renderer().render(config, camera, *integrator);
+	if (cache != nullptr) {
+		printf("Radiance cache occupancy: %zu / %zu cells\n", cache->occupiedCellCount(), cache->cellCount());
+	}
+
 	return 0;
 }
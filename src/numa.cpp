@@ -0,0 +1,220 @@
+#include "numa.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+/// @brief Parse a sysfs CPU/node list, e.g. "0-3,8,10-11".
+/// @param list
+/// @return Expanded list of indices.
+static std::vector<uint32_t> parseList(std::string const& list)
+{
+	std::vector<uint32_t> values{};
+	size_t begin = 0;
+	while (begin < list.size())
+	{
+		size_t end = list.find(',', begin);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+
+		unsigned first = 0;
+		unsigned last = 0;
+		std::string const range = list.substr(begin, end - begin);
+		int const count = sscanf(range.c_str(), "%u-%u", &first, &last);
+		if (count == 1) {
+			values.push_back(first);
+		}
+		else if (count == 2) {
+			for (unsigned i = first; i <= last; i++) {
+				values.push_back(i);
+			}
+		}
+
+		begin = end + 1;
+	}
+
+	return values;
+}
+
+/// @brief Read the first line of a text file.
+/// @param path
+/// @param line Output parameter containing the line without trailing newline.
+/// @return true if the file could be read.
+static bool readLine(std::string const& path, std::string& line)
+{
+	FILE* file = fopen(path.c_str(), "r");
+	if (file == nullptr) {
+		return false;
+	}
+
+	char buffer[4096];
+	bool const success = fgets(buffer, sizeof(buffer), file) != nullptr;
+	fclose(file);
+
+	if (success)
+	{
+		line = buffer;
+		while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+			line.pop_back();
+		}
+	}
+
+	return success;
+}
+
+NumaTopology NumaTopology::detect()
+{
+#ifdef __linux__
+	std::string onlineNodes;
+	if (!readLine("/sys/devices/system/node/online", onlineNodes)) {
+		return singleNode();
+	}
+
+	// Only CPUs available to this process are used for workers
+	cpu_set_t available;
+	CPU_ZERO(&available);
+	bool const hasAffinity = sched_getaffinity(0, sizeof(available), &available) == 0;
+
+	NumaTopology topology{};
+	for (uint32_t const nodeID : parseList(onlineNodes))
+	{
+		std::string cpuList;
+		if (!readLine("/sys/devices/system/node/node" + std::to_string(nodeID) + "/cpulist", cpuList)) {
+			continue;
+		}
+
+		NumaNode node{ nodeID, {} };
+		for (uint32_t const cpu : parseList(cpuList))
+		{
+			if (!hasAffinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &available))) {
+				node.cpus.push_back(cpu);
+			}
+		}
+
+		// Memory-only nodes have no CPUs to run workers on
+		if (node.cpus.empty()) {
+			continue;
+		}
+
+		topology.m_nodes.push_back(std::move(node));
+	}
+
+	if (topology.m_nodes.empty()) {
+		return singleNode();
+	}
+
+	topology.assignWorkerSlots();
+	return topology;
+#else
+	return singleNode();
+#endif
+}
+
+NumaTopology NumaTopology::singleNode()
+{
+	uint32_t const cpuCount = std::max(std::thread::hardware_concurrency(), 1U);
+
+	NumaTopology topology{};
+	NumaNode node{ 0, {} };
+	for (uint32_t cpu = 0; cpu < cpuCount; cpu++) {
+		node.cpus.push_back(cpu);
+	}
+
+	topology.m_nodes.push_back(std::move(node));
+	topology.assignWorkerSlots();
+	return topology;
+}
+
+uint32_t NumaTopology::workerNode(uint32_t worker) const
+{
+	return m_cpuNodes[worker % m_cpuNodes.size()];
+}
+
+uint32_t NumaTopology::workerCPU(uint32_t worker) const
+{
+	return m_cpus[worker % m_cpus.size()];
+}
+
+void NumaTopology::assignWorkerSlots()
+{
+	// Round-robin over nodes, nodes with fewer CPUs drop out once all their CPUs are used
+	m_cpuNodes.clear();
+	m_cpus.clear();
+	for (size_t i = 0, remaining = 1; remaining > 0; i++)
+	{
+		remaining = 0;
+		for (uint32_t node = 0; node < nodeCount(); node++)
+		{
+			if (i < m_nodes[node].cpus.size())
+			{
+				m_cpuNodes.push_back(node);
+				m_cpus.push_back(m_nodes[node].cpus[i]);
+				remaining++;
+			}
+		}
+	}
+}
+
+void NumaTopology::runOnNode(uint32_t node, std::function<void()> const& function) const
+{
+	std::thread thread([&]() {
+		ScopedThreadAffinity const affinity(m_nodes[node].cpus);
+		function();
+	});
+
+	thread.join();
+}
+
+ScopedThreadAffinity::ScopedThreadAffinity(std::vector<uint32_t> const& cpus)
+{
+#ifdef __linux__
+	cpu_set_t previous;
+	CPU_ZERO(&previous);
+	if (sched_getaffinity(0, sizeof(previous), &previous) != 0) {
+		return;
+	}
+
+	for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (CPU_ISSET(cpu, &previous)) {
+			m_previous.push_back(cpu);
+		}
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (uint32_t const cpu : cpus)
+	{
+		if (cpu < CPU_SETSIZE) {
+			CPU_SET(cpu, &set);
+		}
+	}
+
+	m_restore = sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	(void)cpus;
+#endif
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity()
+{
+#ifdef __linux__
+	if (!m_restore) {
+		return;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (uint32_t const cpu : m_previous) {
+		CPU_SET(cpu, &set);
+	}
+
+	sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
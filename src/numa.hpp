@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// @brief A NUMA node with its associated logical CPUs.
+struct NumaNode
+{
+	uint32_t				id;
+	std::vector<uint32_t>	cpus;
+};
+
+/// @brief The NumaTopology describes the NUMA nodes of the host & maps render workers onto them.
+class NumaTopology
+{
+public:
+	/// @brief Detect the host NUMA topology through sysfs, falls back to a single node on other platforms.
+	/// @return
+	static NumaTopology detect();
+
+	/// @brief Create a single node topology containing all logical CPUs.
+	/// @return
+	static NumaTopology singleNode();
+
+	/// @brief Get the node a render worker is placed on, workers are spread over nodes round-robin (worker i on node i % nodeCount).
+	/// @param worker Worker index.
+	/// @return Node index (not the OS node id).
+	uint32_t workerNode(uint32_t worker) const;
+
+	/// @brief Get the logical CPU a render worker is placed on.
+	/// @param worker Worker index.
+	/// @return
+	uint32_t workerCPU(uint32_t worker) const;
+
+	/// @brief Run a function on a thread pinned to a node & wait for it, memory first touched by the function is allocated node-local.
+	/// @param node Node index.
+	/// @param function
+	void runOnNode(uint32_t node, std::function<void()> const& function) const;
+
+	uint32_t nodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+	NumaNode const& node(uint32_t node) const { return m_nodes[node]; }
+
+private:
+	/// @brief Build the worker slot list by interleaving node CPUs, so any worker count is spread over all nodes.
+	void assignWorkerSlots();
+
+private:
+	std::vector<NumaNode>	m_nodes		= {};
+	std::vector<uint32_t>	m_cpuNodes	= {}; //< node index per worker slot
+	std::vector<uint32_t>	m_cpus		= {}; //< CPU per worker slot, taking the next CPU of each node in turn
+};
+
+/// @brief The ScopedThreadAffinity pins the calling thread to a set of CPUs, restoring the previous affinity on destruction.
+/// Pinning is a no-op on platforms without thread affinity support.
+class ScopedThreadAffinity
+{
+public:
+	ScopedThreadAffinity(std::vector<uint32_t> const& cpus);
+	~ScopedThreadAffinity();
+
+	ScopedThreadAffinity(ScopedThreadAffinity const&) = delete;
+	ScopedThreadAffinity& operator=(ScopedThreadAffinity const&) = delete;
+
+private:
+	bool					m_restore	= false;
+	std::vector<uint32_t>	m_previous	= {};
+};
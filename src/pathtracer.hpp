@@ -0,0 +1,11 @@
+#pragma once
+
+/// @file pathtracer.hpp
+/// @brief Public interface of the pathtracer_core library for embedding the renderer in other applications.
+
+#include "batch.hpp"
+#include "bdpt.hpp"
+#include "camera.hpp"
+#include "integrator.hpp"
+#include "renderer.hpp"
+#include "scene.hpp"
@@ -0,0 +1,357 @@
+#include "preview.hpp"
+
+#include <cstdio>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "framebuffer.hpp"
+#include "ray.hpp"
+#include "sampler.hpp"
+
+PreviewBuffer::~PreviewBuffer()
+{
+	release();
+}
+
+bool PreviewBuffer::create(std::string const& name, uint32_t width, uint32_t height)
+{
+	release();
+	m_name = name;
+	m_size = sizeof(PreviewHeader) + static_cast<size_t>(width) * height * sizeof(uint32_t);
+
+#ifdef _WIN32
+	uint64_t const size = static_cast<uint64_t>(m_size);
+	HANDLE const handle = CreateFileMappingA(
+		INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF),
+		m_name.c_str()
+	);
+
+	if (handle != nullptr)
+	{
+		m_handle = handle;
+		m_mapping = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, m_size);
+	}
+#else
+	// Recreate the shared memory object so stale buffers with a different size are not reused
+	shm_unlink(m_name.c_str());
+	int const fd = shm_open(m_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (fd >= 0)
+	{
+		if (ftruncate(fd, static_cast<off_t>(m_size)) == 0)
+		{
+			void* mapping = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			m_mapping = (mapping != MAP_FAILED) ? mapping : nullptr;
+		}
+
+		close(fd);
+	}
+#endif
+
+	bool const isShared = m_mapping != nullptr;
+	if (!isShared)
+	{
+		m_localStorage.resize((m_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+		m_mapping = m_localStorage.data();
+	}
+
+	PreviewHeader* header = new (m_mapping) PreviewHeader{};
+	header->magic = PreviewHeader::Magic;
+	header->width = width;
+	header->height = height;
+	header->sequence.store(0, std::memory_order_release);
+
+	return isShared;
+}
+
+void PreviewBuffer::beginWrite()
+{
+	PreviewHeader* header = static_cast<PreviewHeader*>(m_mapping);
+	header->sequence.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void PreviewBuffer::endWrite(uint32_t pass, uint32_t scale, uint32_t sampleCount, uint32_t generation)
+{
+	PreviewHeader* header = static_cast<PreviewHeader*>(m_mapping);
+	header->pass = pass;
+	header->scale = scale;
+	header->sampleCount = sampleCount;
+	header->generation = generation;
+	header->sequence.fetch_add(1, std::memory_order_release);
+}
+
+uint32_t* PreviewBuffer::pixels()
+{
+	return reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(m_mapping) + sizeof(PreviewHeader));
+}
+
+void PreviewBuffer::release()
+{
+	if (m_mapping == nullptr) {
+		return;
+	}
+
+	if (m_localStorage.empty())
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_mapping);
+		CloseHandle(static_cast<HANDLE>(m_handle));
+#else
+		munmap(m_mapping, m_size);
+		shm_unlink(m_name.c_str());
+#endif
+	}
+
+	m_mapping = nullptr;
+	m_handle = nullptr;
+	m_size = 0;
+	m_localStorage.clear();
+}
+
+PreviewRenderer::PreviewRenderer(PreviewConfig const& config, Integrator const& integrator)
+	:
+	m_config(config),
+	m_pIntegrator(&integrator),
+	m_accumulator(static_cast<size_t>(config.resolutionX) * config.resolutionY)
+{
+	if (m_pIntegrator->usesSplatting()) {
+		m_film = std::make_unique<SplatFilm>(config.resolutionX, config.resolutionY);
+	}
+
+	bool const isShared = m_buffer.create(config.sharedMemoryName, config.resolutionX, config.resolutionY);
+	if (isShared) {
+		printf("Publishing preview to shared memory %s\n", config.sharedMemoryName.c_str());
+	}
+	else {
+		printf("Failed to create shared memory %s, preview is only available in process\n", config.sharedMemoryName.c_str());
+	}
+}
+
+PreviewRenderer::~PreviewRenderer()
+{
+	stop();
+}
+
+void PreviewRenderer::start(Camera const& camera)
+{
+	stop();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_camera = camera;
+		m_cameraTime = Clock::now();
+		m_generation.fetch_add(1, std::memory_order_relaxed);
+		m_running.store(true, std::memory_order_relaxed);
+	}
+
+	m_thread = std::thread(&PreviewRenderer::renderLoop, this);
+}
+
+void PreviewRenderer::setCamera(Camera const& camera)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_camera = camera;
+		m_cameraTime = Clock::now();
+		m_generation.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	m_stateChanged.notify_all();
+}
+
+Camera PreviewRenderer::getCamera() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_camera;
+}
+
+void PreviewRenderer::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_stateChanged.wait(lock, [&]() {
+		return !m_running.load(std::memory_order_relaxed) || m_convergedGeneration == m_generation.load(std::memory_order_relaxed);
+	});
+}
+
+void PreviewRenderer::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_running.store(false, std::memory_order_relaxed);
+	}
+
+	m_stateChanged.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
+
+void PreviewRenderer::renderLoop()
+{
+	while (m_running.load(std::memory_order_relaxed))
+	{
+		// Snapshot camera state, later camera changes cancel this generation
+		Camera camera{};
+		uint64_t generation = 0;
+		Clock::time_point cameraTime{};
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			camera = m_camera;
+			generation = m_generation.load(std::memory_order_relaxed);
+			cameraTime = m_cameraTime;
+		}
+
+		// Coarse passes, splatted contributions are not traced as they would not match the block resolution
+		bool cancelled = false;
+		uint32_t pass = 0;
+		for (uint32_t const scale : CoarseScales)
+		{
+			if (!renderPass(camera, scale, 0, generation)) {
+				cancelled = true;
+				break;
+			}
+
+			publish(false, pass, scale, 1, generation);
+			if (pass == 0)
+			{
+				std::chrono::duration<double, std::milli> const timeToFirstImage = Clock::now() - cameraTime;
+				printf("Preview %llu: time to first image %.3f ms (1/%u resolution)\n", static_cast<unsigned long long>(generation), timeToFirstImage.count(), scale);
+			}
+
+			pass++;
+		}
+
+		// Refinement passes at full resolution
+		if (m_film != nullptr && !cancelled) {
+			m_film->clear();
+		}
+
+		for (uint32_t s = 0; s < m_config.sampleCount && !cancelled; s++)
+		{
+			if (!renderPass(camera, 1, s, generation)) {
+				cancelled = true;
+				break;
+			}
+
+			publish(true, pass++, 1, s + 1, generation);
+		}
+
+		if (cancelled) {
+			continue;
+		}
+
+		std::chrono::duration<double, std::milli> const timeToConverge = Clock::now() - cameraTime;
+		printf("Preview %llu: refined to %u samples in %.3f ms\n", static_cast<unsigned long long>(generation), m_config.sampleCount, timeToConverge.count());
+
+		// Wait for a camera change or stop request
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_convergedGeneration = generation;
+		m_stateChanged.notify_all();
+		m_stateChanged.wait(lock, [&]() {
+			return !m_running.load(std::memory_order_relaxed) || m_generation.load(std::memory_order_relaxed) != generation;
+		});
+	}
+
+	m_stateChanged.notify_all();
+}
+
+bool PreviewRenderer::renderPass(Camera const& camera, uint32_t scale, uint32_t sampleIndex, uint64_t generation)
+{
+	uint32_t const width = m_config.resolutionX;
+	uint32_t const height = m_config.resolutionY;
+	uint32_t const blocksX = (width + scale - 1) / scale;
+	uint32_t const blocksY = (height + scale - 1) / scale;
+	ViewPyramid const view = camera.generateViewPyramid();
+
+	// Coarse passes get no film, so splatting integrators skip light tracing work that would be dropped anyway
+	TraceContext context{};
+	context.camera = &camera;
+	context.film = (scale == 1) ? m_film.get() : nullptr;
+
+	#pragma omp parallel for schedule(dynamic)
+	for (size_t by = 0; by < blocksY; by++)
+	{
+		// Skip remaining work once the camera has changed
+		if (isCancelled(generation)) {
+			continue;
+		}
+
+		for (uint32_t bx = 0; bx < blocksX; bx++)
+		{
+			uint32_t const x0 = bx * scale;
+			uint32_t const y0 = static_cast<uint32_t>(by) * scale;
+			uint32_t const blockWidth = glm::min(scale, width - x0);
+			uint32_t const blockHeight = glm::min(scale, height - y0);
+			size_t const pixelIndex = x0 + static_cast<size_t>(y0) * width;
+
+			uint32_t const pixelSeed = (static_cast<uint32_t>(pixelIndex) + 0x1234) * 0x9E3779B9U + sampleIndex * 0x85EBCA6BU + scale;
+			WhiteNoiseSampler sampler(pixelSeed | 1U);
+
+			// Calculate block UV w/ jitter, coarse blocks are covered by a single sample
+			glm::vec2 const jitter = sampler.sample2D();
+			float const u = (static_cast<float>(x0) + jitter.x * static_cast<float>(blockWidth)) / static_cast<float>(width);
+			float const v = (static_cast<float>(y0) + jitter.y * static_cast<float>(blockHeight)) / static_cast<float>(height);
+
+			// Set up ray
+			glm::vec3 const viewPosition = view.pxTopLeft + u * (view.pxTopRight - view.pxTopLeft) + v * (view.pxBottomLeft - view.pxTopLeft);
+			glm::vec3 const origin = view.origin;
+			glm::vec3 const direction = glm::normalize(viewPosition - origin);
+			Ray const primary(origin, direction);
+
+			TraceContext pixelContext = context;
+			pixelContext.pixelEstimate = (sampleIndex > 0) ? m_accumulator[pixelIndex] / static_cast<float>(sampleIndex) : glm::vec3(0.0F);
+			glm::vec3 const sample = m_pIntegrator->trace(primary, sampler, pixelContext);
+
+			// Fill block, the first sample of a pass sequence replaces previous pass data
+			for (uint32_t y = y0; y < y0 + blockHeight; y++)
+			{
+				for (uint32_t x = x0; x < x0 + blockWidth; x++)
+				{
+					glm::vec3& pixel = m_accumulator[x + static_cast<size_t>(y) * width];
+					pixel = (sampleIndex == 0) ? sample : pixel + sample;
+				}
+			}
+		}
+	}
+
+	return !isCancelled(generation);
+}
+
+void PreviewRenderer::publish(bool includeSplats, uint32_t pass, uint32_t scale, uint32_t sampleCount, uint64_t generation)
+{
+	uint32_t const width = m_config.resolutionX;
+	uint32_t const height = m_config.resolutionY;
+	float const invSampleCount = 1.0F / static_cast<float>(sampleCount);
+	SplatFilm const* film = includeSplats ? m_film.get() : nullptr;
+
+	// Resolve directly into the shared buffer
+	m_buffer.beginWrite();
+	uint32_t* pixels = m_buffer.pixels();
+
+	#pragma omp parallel for
+	for (size_t y = 0; y < height; y++)
+	{
+		for (uint32_t x = 0; x < width; x++)
+		{
+			size_t const idx = x + y * width;
+			glm::vec3 value = m_accumulator[idx];
+			if (film != nullptr) {
+				value += film->get(x, static_cast<uint32_t>(y));
+			}
+
+			pixels[idx] = packPixelRGBA8(value * invSampleCount);
+		}
+	}
+
+	m_buffer.endWrite(pass, scale, sampleCount, static_cast<uint32_t>(generation));
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+#include "film.hpp"
+#include "integrator.hpp"
+
+/// @brief Header of the shared preview framebuffer, followed by width * height RGBA8 pixels (R in the lowest byte).
+/// Viewers map the buffer & poll the sequence counter: an odd sequence means a pass is being published,
+/// a sequence that changed while reading pixels means the read image may be torn & should be read again.
+struct PreviewHeader
+{
+	static constexpr uint32_t Magic = 0x56505450; //< "PTPV"
+
+	uint32_t				magic;
+	uint32_t				width;
+	uint32_t				height;
+	uint32_t				pass;			//< progressive pass index of the published image, restarts at 0 on camera changes
+	uint32_t				scale;			//< pixel block size of the published pass, 1 for full resolution
+	uint32_t				sampleCount;	//< samples per pixel of the published pass
+	uint32_t				generation;		//< incremented on every camera change
+	uint32_t				reserved;
+	std::atomic<uint64_t>	sequence;
+};
+
+/// @brief The PreviewBuffer is a named shared memory framebuffer that viewers can poll without copying.
+/// Falls back to process-local memory if shared memory is not available.
+class PreviewBuffer
+{
+public:
+	PreviewBuffer() = default;
+	~PreviewBuffer();
+
+	PreviewBuffer(PreviewBuffer const&) = delete;
+	PreviewBuffer& operator=(PreviewBuffer const&) = delete;
+
+	/// @brief Create the shared framebuffer, replacing an existing buffer with the same name.
+	/// @param name Shared memory object name, e.g. "/pathtracer_preview".
+	/// @param width
+	/// @param height
+	/// @return true if the buffer is shared, false if process-local memory is used.
+	bool create(std::string const& name, uint32_t width, uint32_t height);
+
+	/// @brief Mark the start of publishing a pass, viewers will not read pixels until endWrite.
+	void beginWrite();
+
+	/// @brief Mark the end of publishing a pass.
+	/// @param pass
+	/// @param scale
+	/// @param sampleCount
+	/// @param generation
+	void endWrite(uint32_t pass, uint32_t scale, uint32_t sampleCount, uint32_t generation);
+
+	/// @brief Get the mapped pixel data, only valid to write between beginWrite & endWrite.
+	/// @return
+	uint32_t* pixels();
+
+private:
+	void release();
+
+private:
+	std::string				m_name			= {};
+	void*					m_mapping		= nullptr;
+	size_t					m_size			= 0;
+	void*					m_handle		= nullptr; //< file mapping handle on Windows
+	std::vector<uint64_t>	m_localStorage	= {};
+};
+
+/// @brief Preview configuration data.
+struct PreviewConfig
+{
+	uint32_t	resolutionX;
+	uint32_t	resolutionY;
+	uint32_t	sampleCount;									//< samples per pixel after which refinement stops
+	std::string	sharedMemoryName	= "/pathtracer_preview";
+};
+
+/// @brief The PreviewRenderer renders progressively on a background thread for interactive viewing.
+/// Coarse passes at 1/8, 1/4 & 1/2 resolution with 1 sample per pixel are published first, followed by full resolution
+/// refinement passes. Camera changes cancel the in-flight pass & restart from the coarsest pass.
+class PreviewRenderer
+{
+public:
+	/// @brief Create a preview renderer, the integrator must outlive the preview renderer.
+	/// @param config
+	/// @param integrator Integrator with associated scene to use for rendering.
+	PreviewRenderer(PreviewConfig const& config, Integrator const& integrator);
+	~PreviewRenderer();
+
+	PreviewRenderer(PreviewRenderer const&) = delete;
+	PreviewRenderer& operator=(PreviewRenderer const&) = delete;
+
+	/// @brief Start rendering on a background thread.
+	/// @param camera
+	void start(Camera const& camera);
+
+	/// @brief Update the camera, cancelling in-flight work & restarting from the coarsest pass.
+	/// @param camera
+	void setCamera(Camera const& camera);
+
+	/// @brief Get the current camera.
+	/// @return
+	Camera getCamera() const;
+
+	/// @brief Wait until the current camera has been refined to the configured sample count.
+	void wait();
+
+	/// @brief Stop rendering & join the background thread.
+	void stop();
+
+public:
+	/// @brief Pixel block sizes of the coarse preview passes.
+	static constexpr uint32_t CoarseScales[] = { 8, 4, 2 };
+
+private:
+	void renderLoop();
+
+	/// @brief Render a pass into the accumulator.
+	/// @param camera
+	/// @param scale Pixel block size, each block is rendered with a single sample.
+	/// @param sampleIndex Refinement sample index, 0 for coarse passes.
+	/// @param generation Camera generation the pass is rendered for.
+	/// @return false if the pass was cancelled by a camera change.
+	bool renderPass(Camera const& camera, uint32_t scale, uint32_t sampleIndex, uint64_t generation);
+
+	/// @brief Publish the accumulator to the shared preview buffer.
+	/// @param includeSplats Add the splat film to the accumulated samples.
+	/// @param pass
+	/// @param scale
+	/// @param sampleCount Number of samples accumulated per pixel.
+	/// @param generation
+	void publish(bool includeSplats, uint32_t pass, uint32_t scale, uint32_t sampleCount, uint64_t generation);
+
+	bool isCancelled(uint64_t generation) const { return m_generation.load(std::memory_order_relaxed) != generation || !m_running.load(std::memory_order_relaxed); }
+
+private:
+	using Clock = std::chrono::high_resolution_clock;
+
+	PreviewConfig					m_config			= {};
+	Integrator const*				m_pIntegrator		= nullptr;
+	PreviewBuffer					m_buffer			= {};
+	std::vector<glm::vec3>			m_accumulator		= {};
+	std::unique_ptr<SplatFilm>		m_film				= {}; //< only allocated for splatting integrators
+
+	// -- Render Thread State --
+	std::thread						m_thread			= {};
+	mutable std::mutex				m_mutex				= {};
+	std::condition_variable			m_stateChanged		= {};
+	Camera							m_camera			= {};
+	Clock::time_point				m_cameraTime		= {}; //< time of the last camera change, used for time to first image
+	std::atomic<uint64_t>			m_generation		= { 0 };
+	uint64_t						m_convergedGeneration	= ~0ULL;
+	std::atomic<bool>				m_running			= { false };
+};
@@ -0,0 +1,484 @@
+#include "primitive.hpp"
+
+#include <cassert>
+#include <limits>
+
+static constexpr float PI				= 3.14159265358979F;
+static constexpr float TWO_PI			= 2.0F * PI;
+static constexpr float HIT_EPSILON		= 1e-4F;	//< min hit distance, rejects self intersections of offset rays
+static constexpr float BOUNDS_EPSILON	= 1e-4F;	//< padding for flat primitive bounds
+static constexpr float MIN_SOLID_ANGLE	= 1e-5F;	//< spherical rectangles below this solid angle are sampled by area
+static constexpr float MAX_QUAD_SKEW	= 1e-3F;	//< max cosine between quad edges
+
+/// @brief Create an orthonormal tangent for a normal (Building an Orthonormal Basis, Revisited, Duff et al.)
+/// @param n
+/// @return
+static glm::vec3 orthonormalTangent(glm::vec3 const& n)
+{
+	float const sign = n.z >= 0.0F ? 1.0F : -1.0F;
+	float const a = -1.0F / (sign + n.z);
+	float const b = n.x * n.y * a;
+	return glm::vec3(1.0F + sign * n.x * n.x * a, sign * b, -sign * n.x);
+}
+
+/// @brief Map a unit square sample to the unit disk (A Low Distortion Map Between Disk and Square, Shirley & Chiu).
+/// @param eta
+/// @return
+static glm::vec2 sampleConcentricDisk(glm::vec2 const& eta)
+{
+	glm::vec2 const offset = 2.0F * eta - glm::vec2(1.0F);
+	if (offset.x == 0.0F && offset.y == 0.0F) {
+		return glm::vec2(0.0F);
+	}
+
+	float r = 0.0F;
+	float theta = 0.0F;
+	if (glm::abs(offset.x) > glm::abs(offset.y)) {
+		r = offset.x;
+		theta = (PI / 4.0F) * (offset.y / offset.x);
+	}
+	else {
+		r = offset.y;
+		theta = (PI / 2.0F) - (PI / 4.0F) * (offset.x / offset.y);
+	}
+
+	return r * glm::vec2(glm::cos(theta), glm::sin(theta));
+}
+
+/// @brief Spherical rectangle as seen from a reference point (An Area-Preserving Parametrization for Spherical Rectangles, Urena et al.)
+struct SphericalRectangle
+{
+	glm::vec3 origin;
+	glm::vec3 x, y, z;
+	float z0, z0sq;
+	float x0, y0, y0sq;
+	float x1, y1, y1sq;
+	float b0, b1, b0sq;
+	float k;
+	float solidAngle;
+
+	SphericalRectangle(glm::vec3 const& corner, glm::vec3 const& edgeU, glm::vec3 const& edgeV, glm::vec3 const& reference)
+	{
+		float const edgeULength = glm::length(edgeU);
+		float const edgeVLength = glm::length(edgeV);
+		origin = reference;
+		x = edgeU / edgeULength;
+		y = edgeV / edgeVLength;
+		z = glm::cross(x, y);
+
+		// Local reference system, z points away from the rectangle
+		glm::vec3 const d = corner - reference;
+		z0 = glm::dot(d, z);
+		if (z0 > 0.0F) {
+			z *= -1.0F;
+			z0 *= -1.0F;
+		}
+
+		z0sq = z0 * z0;
+		x0 = glm::dot(d, x);
+		y0 = glm::dot(d, y);
+		x1 = x0 + edgeULength;
+		y1 = y0 + edgeVLength;
+		y0sq = y0 * y0;
+		y1sq = y1 * y1;
+
+		// Normals of the spherical rectangle edges
+		glm::vec3 const v00(x0, y0, z0);
+		glm::vec3 const v01(x0, y1, z0);
+		glm::vec3 const v10(x1, y0, z0);
+		glm::vec3 const v11(x1, y1, z0);
+		glm::vec3 const n0 = glm::normalize(glm::cross(v00, v10));
+		glm::vec3 const n1 = glm::normalize(glm::cross(v10, v11));
+		glm::vec3 const n2 = glm::normalize(glm::cross(v11, v01));
+		glm::vec3 const n3 = glm::normalize(glm::cross(v01, v00));
+
+		// Internal angles
+		float const g0 = glm::acos(glm::clamp(-glm::dot(n0, n1), -1.0F, 1.0F));
+		float const g1 = glm::acos(glm::clamp(-glm::dot(n1, n2), -1.0F, 1.0F));
+		float const g2 = glm::acos(glm::clamp(-glm::dot(n2, n3), -1.0F, 1.0F));
+		float const g3 = glm::acos(glm::clamp(-glm::dot(n3, n0), -1.0F, 1.0F));
+
+		b0 = n0.z;
+		b1 = n2.z;
+		b0sq = b0 * b0;
+		k = TWO_PI - g2 - g3;
+		solidAngle = g0 + g1 - k;
+	}
+
+	glm::vec3 sample(glm::vec2 const& eta) const
+	{
+		// Compute cu
+		float const au = eta.x * solidAngle + k;
+		float const fu = (glm::cos(au) * b0 - b1) / glm::sin(au);
+		float cu = 1.0F / glm::sqrt(fu * fu + b0sq) * (fu > 0.0F ? 1.0F : -1.0F);
+		cu = glm::clamp(cu, -1.0F, 1.0F);
+
+		// Compute xu
+		float xu = -(cu * z0) / glm::sqrt(glm::max(1.0F - cu * cu, 1e-12F));
+		xu = glm::clamp(xu, x0, x1);
+
+		// Compute yv
+		float const d = glm::sqrt(xu * xu + z0sq);
+		float const h0 = y0 / glm::sqrt(d * d + y0sq);
+		float const h1 = y1 / glm::sqrt(d * d + y1sq);
+		float const hv = h0 + eta.y * (h1 - h0);
+		float const hv2 = hv * hv;
+		float const yv = (hv2 < 1.0F - 1e-6F) ? (hv * d) / glm::sqrt(1.0F - hv2) : y1;
+
+		return origin + xu * x + yv * y + z0 * z;
+	}
+};
+
+AnalyticPrimitive AnalyticPrimitive::sphere(glm::vec3 const& center, float radius, uint32_t material)
+{
+	AnalyticPrimitive primitive{};
+	primitive.type = PrimitiveType::Sphere;
+	primitive.position = center;
+	primitive.radius = radius;
+	primitive.material = material;
+	return primitive;
+}
+
+AnalyticPrimitive AnalyticPrimitive::quad(glm::vec3 const& corner, glm::vec3 const& edgeU, glm::vec3 const& edgeV, uint32_t material)
+{
+	// Intersection & spherical rectangle sampling project onto the edges, which is only valid for rectangles
+	assert(glm::length(edgeU) > 0.0F && glm::length(edgeV) > 0.0F && "Quad edges must not be degenerate");
+	assert(glm::abs(glm::dot(glm::normalize(edgeU), glm::normalize(edgeV))) <= MAX_QUAD_SKEW && "Quad edges must be orthogonal");
+
+	AnalyticPrimitive primitive{};
+	primitive.type = PrimitiveType::Quad;
+	primitive.position = corner;
+	primitive.normal = glm::normalize(glm::cross(edgeU, edgeV));
+	primitive.edgeU = edgeU;
+	primitive.edgeV = edgeV;
+	primitive.material = material;
+	return primitive;
+}
+
+AnalyticPrimitive AnalyticPrimitive::disk(glm::vec3 const& center, glm::vec3 const& normal, float radius, uint32_t material)
+{
+	AnalyticPrimitive primitive{};
+	primitive.type = PrimitiveType::Disk;
+	primitive.position = center;
+	primitive.normal = glm::normalize(normal);
+	primitive.radius = radius;
+	primitive.material = material;
+	return primitive;
+}
+
+void AnalyticPrimitive::bounds(glm::vec3& min, glm::vec3& max) const
+{
+	switch (type)
+	{
+	case PrimitiveType::Sphere:
+		min = position - glm::vec3(radius);
+		max = position + glm::vec3(radius);
+		break;
+	case PrimitiveType::Quad:
+		min = glm::min(glm::min(position, position + edgeU), glm::min(position + edgeV, position + edgeU + edgeV)) - glm::vec3(BOUNDS_EPSILON);
+		max = glm::max(glm::max(position, position + edgeU), glm::max(position + edgeV, position + edgeU + edgeV)) + glm::vec3(BOUNDS_EPSILON);
+		break;
+	case PrimitiveType::Disk:
+	{
+		// Extent of a circle along each axis is radius * sin(angle between axis & normal)
+		glm::vec3 const extent = radius * glm::sqrt(glm::max(glm::vec3(1.0F) - normal * normal, glm::vec3(0.0F)));
+		min = position - extent - glm::vec3(BOUNDS_EPSILON);
+		max = position + extent + glm::vec3(BOUNDS_EPSILON);
+		break;
+	}
+	}
+}
+
+bool AnalyticPrimitive::intersect(glm::vec3 const& origin, glm::vec3 const& direction, float tMax, float& t, glm::vec2& uv) const
+{
+	if (type == PrimitiveType::Sphere)
+	{
+		glm::vec3 const oc = origin - position;
+		float const b = glm::dot(oc, direction);
+		float const c = glm::dot(oc, oc) - radius * radius;
+		float const discriminant = b * b - c;
+		if (discriminant < 0.0F) {
+			return false;
+		}
+
+		float const s = glm::sqrt(discriminant);
+		float const tNear = -b - s;
+		float const tHit = (tNear > HIT_EPSILON) ? tNear : -b + s;
+		if (tHit <= HIT_EPSILON || tHit >= tMax) {
+			return false;
+		}
+
+		glm::vec3 const n = (oc + tHit * direction) / radius;
+		t = tHit;
+		uv = glm::vec2(0.5F + glm::atan(n.z, n.x) / TWO_PI, glm::acos(glm::clamp(n.y, -1.0F, 1.0F)) / PI);
+		return true;
+	}
+
+	// Quads & disks intersect their plane first
+	float const denom = glm::dot(direction, normal);
+	if (glm::abs(denom) < 1e-8F) {
+		return false;
+	}
+
+	float const tHit = glm::dot(position - origin, normal) / denom;
+	if (tHit <= HIT_EPSILON || tHit >= tMax) {
+		return false;
+	}
+
+	glm::vec3 const local = origin + tHit * direction - position;
+	if (type == PrimitiveType::Quad)
+	{
+		float const u = glm::dot(local, edgeU) / glm::dot(edgeU, edgeU);
+		float const v = glm::dot(local, edgeV) / glm::dot(edgeV, edgeV);
+		if (u < 0.0F || u > 1.0F || v < 0.0F || v > 1.0F) {
+			return false;
+		}
+
+		t = tHit;
+		uv = glm::vec2(u, v);
+		return true;
+	}
+
+	float const distance2 = glm::dot(local, local);
+	if (distance2 > radius * radius) {
+		return false;
+	}
+
+	t = tHit;
+	uv = glm::vec2(glm::sqrt(distance2) / radius, 0.0F);
+	return true;
+}
+
+glm::vec3 AnalyticPrimitive::normalAt(glm::vec3 const& point) const
+{
+	if (type == PrimitiveType::Sphere) {
+		return glm::normalize(point - position);
+	}
+
+	return normal;
+}
+
+glm::vec3 AnalyticPrimitive::tangentAt(glm::vec3 const& point) const
+{
+	if (type == PrimitiveType::Quad) {
+		return glm::normalize(edgeU);
+	}
+
+	return orthonormalTangent(normalAt(point));
+}
+
+float AnalyticPrimitive::area() const
+{
+	switch (type)
+	{
+	case PrimitiveType::Sphere:
+		return 4.0F * PI * radius * radius;
+	case PrimitiveType::Quad:
+		return glm::length(glm::cross(edgeU, edgeV));
+	case PrimitiveType::Disk:
+		return PI * radius * radius;
+	}
+
+	return 0.0F;
+}
+
+glm::vec3 AnalyticPrimitive::sampleArea(Sampler& sampler, glm::vec3& sampledNormal) const
+{
+	glm::vec2 const eta = sampler.sample2D();
+	switch (type)
+	{
+	case PrimitiveType::Sphere:
+	{
+		float const z = 1.0F - 2.0F * eta.x;
+		float const r = glm::sqrt(glm::max(0.0F, 1.0F - z * z));
+		float const phi = TWO_PI * eta.y;
+		sampledNormal = glm::vec3(r * glm::cos(phi), r * glm::sin(phi), z);
+		return position + radius * sampledNormal;
+	}
+	case PrimitiveType::Quad:
+		sampledNormal = normal;
+		return position + eta.x * edgeU + eta.y * edgeV;
+	case PrimitiveType::Disk:
+	{
+		glm::vec3 const tangent = orthonormalTangent(normal);
+		glm::vec3 const bitangent = glm::cross(normal, tangent);
+		glm::vec2 const disk = radius * sampleConcentricDisk(eta);
+		sampledNormal = normal;
+		return position + disk.x * tangent + disk.y * bitangent;
+	}
+	}
+
+	sampledNormal = normal;
+	return position;
+}
+
+bool AnalyticPrimitive::sampleSolidAngle(glm::vec3 const& reference, Sampler& sampler, glm::vec3& direction, float& distance, float& pdf) const
+{
+	if (type == PrimitiveType::Sphere)
+	{
+		glm::vec3 const toCenter = position - reference;
+		float const distance2 = glm::dot(toCenter, toCenter);
+		if (distance2 > radius * radius)
+		{
+			// Uniformly sample the cone of directions subtended by the sphere
+			float const centerDistance = glm::sqrt(distance2);
+			glm::vec3 const w = toCenter / centerDistance;
+			float const sinThetaMax2 = (radius * radius) / distance2;
+			float const oneMinusCosThetaMax = (sinThetaMax2 < 1e-4F) ? 0.5F * sinThetaMax2 : 1.0F - glm::sqrt(1.0F - sinThetaMax2);
+
+			glm::vec2 const eta = sampler.sample2D();
+			float const cosTheta = 1.0F - eta.x * oneMinusCosThetaMax;
+			float const sinTheta = glm::sqrt(glm::max(0.0F, 1.0F - cosTheta * cosTheta));
+			float const phi = TWO_PI * eta.y;
+
+			glm::vec3 const tangent = orthonormalTangent(w);
+			glm::vec3 const bitangent = glm::cross(w, tangent);
+			direction = glm::normalize(tangent * (sinTheta * glm::cos(phi)) + bitangent * (sinTheta * glm::sin(phi)) + w * cosTheta);
+
+			// Distance to the near sphere surface, grazing directions are clamped to the tangent point
+			float const b = glm::dot(-toCenter, direction);
+			float const discriminant = glm::max(b * b - (distance2 - radius * radius), 0.0F);
+			distance = -b - glm::sqrt(discriminant);
+			pdf = 1.0F / (TWO_PI * oneMinusCosThetaMax);
+			return distance > 0.0F;
+		}
+	}
+	else if (type == PrimitiveType::Quad)
+	{
+		SphericalRectangle const rectangle(position, edgeU, edgeV, reference);
+		if (rectangle.solidAngle > MIN_SOLID_ANGLE)
+		{
+			glm::vec3 const point = rectangle.sample(sampler.sample2D());
+			glm::vec3 const toPoint = point - reference;
+			distance = glm::length(toPoint);
+			if (distance <= 0.0F) {
+				return false;
+			}
+
+			direction = toPoint / distance;
+			pdf = 1.0F / rectangle.solidAngle;
+			return true;
+		}
+	}
+
+	// Sample by area & convert to solid angle density
+	glm::vec3 sampledNormal{};
+	glm::vec3 const point = sampleArea(sampler, sampledNormal);
+	glm::vec3 const toPoint = point - reference;
+	float const distance2 = glm::dot(toPoint, toPoint);
+	if (distance2 <= 0.0F) {
+		return false;
+	}
+
+	distance = glm::sqrt(distance2);
+	direction = toPoint / distance;
+	float const cosTheta = glm::abs(glm::dot(sampledNormal, direction));
+	if (cosTheta <= 0.0F) {
+		return false;
+	}
+
+	pdf = distance2 / (cosTheta * area());
+	return true;
+}
+
+float AnalyticPrimitive::solidAnglePDF(glm::vec3 const& reference, glm::vec3 const& direction) const
+{
+	if (type == PrimitiveType::Sphere)
+	{
+		glm::vec3 const toCenter = position - reference;
+		float const distance2 = glm::dot(toCenter, toCenter);
+		if (distance2 > radius * radius)
+		{
+			float const sinThetaMax2 = (radius * radius) / distance2;
+			float const oneMinusCosThetaMax = (sinThetaMax2 < 1e-4F) ? 0.5F * sinThetaMax2 : 1.0F - glm::sqrt(1.0F - sinThetaMax2);
+			float const cosTheta = glm::dot(toCenter, direction) / glm::sqrt(distance2);
+			return (cosTheta >= 1.0F - oneMinusCosThetaMax) ? 1.0F / (TWO_PI * oneMinusCosThetaMax) : 0.0F;
+		}
+	}
+
+	float t = 0.0F;
+	glm::vec2 uv{};
+	if (!intersect(reference, direction, std::numeric_limits<float>::max(), t, uv)) {
+		return 0.0F;
+	}
+
+	if (type == PrimitiveType::Quad)
+	{
+		SphericalRectangle const rectangle(position, edgeU, edgeV, reference);
+		if (rectangle.solidAngle > MIN_SOLID_ANGLE) {
+			return 1.0F / rectangle.solidAngle;
+		}
+	}
+
+	// Area sampling density converted to solid angle
+	glm::vec3 const point = reference + t * direction;
+	float const cosTheta = glm::abs(glm::dot(normalAt(point), direction));
+	if (cosTheta <= 0.0F) {
+		return 0.0F;
+	}
+
+	return (t * t) / (cosTheta * area());
+}
+
+Mesh AnalyticPrimitive::tessellate(uint32_t segments) const
+{
+	Mesh mesh{};
+	auto const addTriangle = [&](glm::vec3 const& p0, glm::vec3 const& p1, glm::vec3 const& p2) {
+		// Skip degenerate triangles, e.g. at sphere poles
+		if (glm::length(glm::cross(p1 - p0, p2 - p0)) <= 0.0F) {
+			return;
+		}
+
+		for (glm::vec3 const& p : { p0, p1, p2 })
+		{
+			mesh.vertices.push_back(Vertex{ p, normalAt(p), tangentAt(p), glm::vec2(0.0F) });
+			mesh.indices.push_back(static_cast<uint32_t>(mesh.indices.size()));
+		}
+	};
+
+	switch (type)
+	{
+	case PrimitiveType::Sphere:
+	{
+		mesh.name = "TessellatedSphere";
+		uint32_t const rings = glm::max(segments / 2, 2U);
+		auto const point = [&](uint32_t ring, uint32_t segment) {
+			float const theta = PI * static_cast<float>(ring) / static_cast<float>(rings);
+			float const phi = TWO_PI * static_cast<float>(segment) / static_cast<float>(segments);
+			return position + radius * glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+		};
+
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				addTriangle(point(ring, segment), point(ring + 1, segment), point(ring + 1, segment + 1));
+				addTriangle(point(ring, segment), point(ring + 1, segment + 1), point(ring, segment + 1));
+			}
+		}
+		break;
+	}
+	case PrimitiveType::Quad:
+		mesh.name = "TessellatedQuad";
+		addTriangle(position, position + edgeU, position + edgeU + edgeV);
+		addTriangle(position, position + edgeU + edgeV, position + edgeV);
+		break;
+	case PrimitiveType::Disk:
+	{
+		mesh.name = "TessellatedDisk";
+		glm::vec3 const tangent = orthonormalTangent(normal);
+		glm::vec3 const bitangent = glm::cross(normal, tangent);
+		auto const point = [&](uint32_t segment) {
+			float const phi = TWO_PI * static_cast<float>(segment) / static_cast<float>(segments);
+			return position + radius * (glm::cos(phi) * tangent + glm::sin(phi) * bitangent);
+		};
+
+		for (uint32_t segment = 0; segment < segments; segment++) {
+			addTriangle(position, point(segment), point(segment + 1));
+		}
+		break;
+	}
+	}
+
+	return mesh;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+#include "sampler.hpp"
+
+/// @brief Analytic primitive shapes.
+enum class PrimitiveType : uint32_t
+{
+	Sphere,
+	Quad,
+	Disk,
+};
+
+/// @brief The AnalyticPrimitive is a shape intersected in closed form instead of being tessellated into triangles.
+/// Emissive primitives are two sided, matching emissive meshes.
+class AnalyticPrimitive
+{
+public:
+	/// @brief Create a sphere.
+	/// @param center
+	/// @param radius
+	/// @param material Scene material index.
+	/// @return
+	static AnalyticPrimitive sphere(glm::vec3 const& center, float radius, uint32_t material);
+
+	/// @brief Create a rectangle spanned by two orthogonal edges, intersection & sampling assume a rectangle.
+	/// @param corner
+	/// @param edgeU
+	/// @param edgeV Must be orthogonal to edgeU.
+	/// @param material Scene material index.
+	/// @return
+	static AnalyticPrimitive quad(glm::vec3 const& corner, glm::vec3 const& edgeU, glm::vec3 const& edgeV, uint32_t material);
+
+	/// @brief Create a disk.
+	/// @param center
+	/// @param normal
+	/// @param radius
+	/// @param material Scene material index.
+	/// @return
+	static AnalyticPrimitive disk(glm::vec3 const& center, glm::vec3 const& normal, float radius, uint32_t material);
+
+	/// @brief Get the world space bounds of the primitive.
+	/// @param min
+	/// @param max
+	void bounds(glm::vec3& min, glm::vec3& max) const;
+
+	/// @brief Intersect a ray with the primitive.
+	/// @param origin
+	/// @param direction Normalized ray direction.
+	/// @param tMax Max hit distance.
+	/// @param t Output parameter containing the hit distance.
+	/// @param uv Output parameter containing the surface parameterization of the hit.
+	/// @return true if the ray hits the primitive before tMax.
+	bool intersect(glm::vec3 const& origin, glm::vec3 const& direction, float tMax, float& t, glm::vec2& uv) const;
+
+	/// @brief Get the geometric normal at a point on the primitive.
+	/// @param point
+	/// @return
+	glm::vec3 normalAt(glm::vec3 const& point) const;
+
+	/// @brief Get a tangent orthogonal to the normal at a point on the primitive.
+	/// @param point
+	/// @return
+	glm::vec3 tangentAt(glm::vec3 const& point) const;
+
+	/// @brief Get the surface area of the primitive.
+	/// @return
+	float area() const;
+
+	/// @brief Uniformly sample a point on the primitive surface, the area PDF is 1 / area().
+	/// @param sampler
+	/// @param normal Output parameter containing the normal at the sampled point.
+	/// @return
+	glm::vec3 sampleArea(Sampler& sampler, glm::vec3& normal) const;
+
+	/// @brief Sample a direction towards the primitive as seen from a reference point.
+	/// Spheres are sampled by their cone of directions, quads as spherical rectangles (An Area-Preserving Parametrization
+	/// for Spherical Rectangles, Urena et al.), disks by area with the PDF converted to solid angle.
+	/// @param reference
+	/// @param sampler
+	/// @param direction Output parameter containing the normalized sampled direction.
+	/// @param distance Output parameter containing the distance to the sampled point.
+	/// @param pdf Output parameter containing the solid angle PDF.
+	/// @return false if no direction could be sampled.
+	bool sampleSolidAngle(glm::vec3 const& reference, Sampler& sampler, glm::vec3& direction, float& distance, float& pdf) const;
+
+	/// @brief Evaluate the solid angle PDF of sampling a direction using sampleSolidAngle.
+	/// @param reference
+	/// @param direction Normalized direction.
+	/// @return
+	float solidAnglePDF(glm::vec3 const& reference, glm::vec3 const& direction) const;
+
+	/// @brief Tessellate the primitive into a triangle mesh.
+	/// @param segments Number of segments around curved edges.
+	/// @return
+	Mesh tessellate(uint32_t segments) const;
+
+public:
+	PrimitiveType	type		= PrimitiveType::Sphere;
+	glm::vec3		position	= {};	//< sphere & disk center, quad corner
+	glm::vec3		normal		= {};	//< quad & disk normal
+	glm::vec3		edgeU		= {};	//< quad edge
+	glm::vec3		edgeV		= {};	//< quad edge
+	float			radius		= 0.0F;	//< sphere & disk radius
+	uint32_t		material	= 0;
+};
@@ -2,71 +2,613 @@
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
+#include <chrono>
 #include <cstdio>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
+#include <omp.h>
 #include <stb_image_write.h>
 
+#include "checkpoint.hpp"
 #include "ray.hpp"
 #include "sampler.hpp"
 
+/// @brief Base of the per-pixel sampler seeds, part of the checkpoint fingerprint since resumed pixels must reuse their seeds.
+static constexpr uint32_t PixelSeedBase = 0x1234;
+
+/// @brief Seek to a 64-bit file offset, required for output files larger than 2 GB.
+/// @param file 
+/// @param offset 
+/// @return 0 on success.
+static int seekFile(FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET);
+#else
+	return fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+}
+
+/// @brief Replace the extension of a file path.
+/// @param path 
+/// @param extension New extension including the leading dot.
+/// @return 
+static std::string replaceExtension(std::string const& path, char const* extension)
+{
+	size_t const separator = path.find_last_of("/\\");
+	size_t const dot = path.find_last_of('.');
+	if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) {
+		return path + extension;
+	}
+
+	return path.substr(0, dot) + extension;
+}
+
+/// @brief Pin the calling render worker to its CPU if requested.
+/// @param topology 
+/// @param worker Worker index.
+/// @param pin 
+/// @return Affinity guard restoring the previous thread affinity, nullptr if the worker is not pinned.
+static std::unique_ptr<ScopedThreadAffinity> pinWorker(NumaTopology const& topology, uint32_t worker, bool pin)
+{
+	if (!pin) {
+		return nullptr;
+	}
+
+	return std::make_unique<ScopedThreadAffinity>(std::vector<uint32_t>{ topology.workerCPU(worker) });
+}
+
+TileScheduler::TileScheduler(size_t tileCount, uint32_t nodeCount)
+	:
+	m_ranges(std::make_unique<TileRange[]>(glm::max(nodeCount, 1U))),
+	m_nodeCount(glm::max(nodeCount, 1U))
+{
+	// Split tiles into contiguous bands, keeping neighbouring tiles on the same node
+	for (uint32_t node = 0; node < m_nodeCount; node++)
+	{
+		m_ranges[node].next.store((tileCount * node) / m_nodeCount, std::memory_order_relaxed);
+		m_ranges[node].end = (tileCount * (node + 1)) / m_nodeCount;
+	}
+}
+
+bool TileScheduler::next(uint32_t node, size_t& tile)
+{
+	// Take tiles from the worker node first, then steal from the following nodes
+	for (uint32_t i = 0; i < m_nodeCount; i++)
+	{
+		TileRange& range = m_ranges[(node + i) % m_nodeCount];
+		if (range.next.load(std::memory_order_relaxed) >= range.end) {
+			continue;
+		}
+
+		size_t const index = range.next.fetch_add(1, std::memory_order_relaxed);
+		if (index < range.end) {
+			tile = index;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void Renderer::render(RendererConfig const& config, Camera const& camera, Integrator const& integrator)
 {
-	std::vector<glm::vec4> image(config.resolutionX * config.resolutionY);
+	WorkerPlacement const placement = createWorkerPlacement(config, integrator);
+
+	if (config.cacheFillSamples > 0 && !integrator.usesSplatting()) {
+		fillRadianceCache(config, camera, integrator, placement);
+	}
+
+	if (config.streaming && integrator.usesSplatting())
+	{
+		// Splatting integrators write to arbitrary pixels, which requires the full frame in memory.
+		// The framebuffer path writes a PNG, so the PPM output name is replaced to match its contents.
+		RendererConfig framebufferConfig = config;
+		framebufferConfig.filename = replaceExtension(config.filename, ".png");
+		printf("Streaming framebuffer does not support splatting integrators, rendering to full framebuffer (%s)\n", framebufferConfig.filename.c_str());
+		renderFramebuffer(framebufferConfig, camera, integrator, placement);
+		return;
+	}
+
+	if (config.streaming)
+	{
+		if (!config.checkpointPath.empty()) {
+			printf("Streaming framebuffer writes finished tiles directly, checkpoints are disabled\n");
+		}
+
+		renderStreaming(config, camera, integrator, placement);
+	}
+	else {
+		renderFramebuffer(config, camera, integrator, placement);
+	}
+}
+
+void Renderer::renderFramebuffer(RendererConfig const& config, Camera const& camera, Integrator const& integrator, WorkerPlacement const& placement)
+{
+	Framebuffer image(config.resolutionX, config.resolutionY, config.halfPrecision);
 	ViewPyramid const view = camera.generateViewPyramid();
+	std::vector<Tile> const tiles = generateTiles(config);
+
+	// Set up splat film for integrators contributing to arbitrary pixels
+	std::unique_ptr<SplatFilm> film = integrator.usesSplatting() ? std::make_unique<SplatFilm>(config.resolutionX, config.resolutionY) : nullptr;
+
+	// While checkpointing, finished pixels commit their splats to the film of the current epoch. Snapshots switch the
+	// epoch & drain the previous epoch film into the main film, so workers are only blocked while switching epochs.
+	bool const bufferSplats = film != nullptr && !config.checkpointPath.empty();
+	std::unique_ptr<SplatFilm> epochFilms[2] = {};
+	if (bufferSplats)
+	{
+		epochFilms[0] = std::make_unique<SplatFilm>(config.resolutionX, config.resolutionY);
+		epochFilms[1] = std::make_unique<SplatFilm>(config.resolutionX, config.resolutionY);
+	}
+
+	TraceContext context{};
+	context.camera = &camera;
+	context.film = film.get();
+
+	// Per pixel sample counts, a pixel value may only be read after its count has been published with release ordering
+	size_t const pixelCount = static_cast<size_t>(config.resolutionX) * config.resolutionY;
+	std::vector<std::atomic<uint32_t>> sampleCounts(pixelCount);
+	std::atomic<uint64_t> lightPathCount{ 0 }; //< light paths splatted to the film, each camera sample traces one
+
+	// Epoch state of buffered splats, the epoch is only written while holding the commit lock exclusively
+	std::shared_mutex commitMutex{};
+	uint32_t epoch = 0;
+	std::atomic<uint64_t> epochLightPathCounts[2] = { { 0 }, { 0 } };
+	std::vector<std::atomic<uint32_t>> commitEpochs(bufferSplats ? pixelCount : 0); //< epoch a pixel committed its splats in, restored pixels use 0
+
+	// Checkpoints only resume renders of the same scene & integrator settings with the same pixel seeds
+	uint64_t const fingerprint = hashFingerprint(&PixelSeedBase, sizeof(PixelSeedBase), config.sceneFingerprint);
+
+	// Restore finished pixels & splats from a matching checkpoint, pixels use fixed seeds so only unfinished pixels are rendered again
+	size_t restoredCount = 0;
+	if (config.resume && !config.checkpointPath.empty())
+	{
+		RenderCheckpoint checkpoint{};
+		if (!RenderCheckpoint::read(config.checkpointPath, checkpoint)) {
+			printf("No valid checkpoint at %s, starting a new render\n", config.checkpointPath.c_str());
+		}
+		else if (checkpoint.resolutionX != config.resolutionX || checkpoint.resolutionY != config.resolutionY
+			|| checkpoint.sampleCount != config.sampleCount || checkpoint.usesSplatting != integrator.usesSplatting()
+			|| checkpoint.fingerprint != fingerprint) {
+			printf("Checkpoint %s does not match the render configuration, starting a new render\n", config.checkpointPath.c_str());
+		}
+		else
+		{
+			for (uint32_t y = 0; y < config.resolutionY; y++)
+			{
+				for (uint32_t x = 0; x < config.resolutionX; x++)
+				{
+					size_t const idx = x + static_cast<size_t>(y) * config.resolutionX;
+					if (film != nullptr) {
+						film->set(x, y, checkpoint.film[idx]);
+					}
+
+					// Partially sampled pixels are rendered again from their first sample
+					if (checkpoint.sampleCounts[idx] == config.sampleCount)
+					{
+						image.store(x, y, checkpoint.pixels[idx]);
+						sampleCounts[idx].store(config.sampleCount, std::memory_order_relaxed);
+						restoredCount++;
+					}
+				}
+			}
+
+			lightPathCount.store(checkpoint.lightPathCount, std::memory_order_relaxed);
+			printf("Resumed from %s: %zu / %zu pixels finished\n", config.checkpointPath.c_str(), restoredCount, pixelCount);
+		}
+	}
+
+	// Published sample counts order the reads of finished pixel values, so snapshots without splats never block workers.
+	// With buffered splats, the epoch switch makes sure sample counts, film & light path count describe the same pixels.
+	std::unique_ptr<CheckpointWriter> checkpointWriter{};
+	if (!config.checkpointPath.empty())
+	{
+		checkpointWriter = std::make_unique<CheckpointWriter>(config.checkpointPath, config.checkpointInterval, [&](RenderCheckpoint& checkpoint) {
+			if (checkpoint.sampleCounts.size() != pixelCount) {
+				checkpoint.reset(config.resolutionX, config.resolutionY, config.sampleCount, film != nullptr);
+			}
+
+			uint32_t drainedEpoch = 0;
+			if (bufferSplats)
+			{
+				// Workers holding the lock shared finish their commits before the switch, later commits use the next epoch
+				{
+					std::unique_lock<std::shared_mutex> const lock(commitMutex);
+					drainedEpoch = epoch++;
+				}
+
+				SplatFilm& drainedFilm = *epochFilms[drainedEpoch % 2];
+				film->accumulate(drainedFilm);
+				drainedFilm.clear();
+				lightPathCount.fetch_add(epochLightPathCounts[drainedEpoch % 2].exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+			}
+
+			checkpoint.fingerprint = fingerprint;
+			checkpoint.lightPathCount = lightPathCount.load(std::memory_order_relaxed);
+			for (uint32_t y = 0; y < config.resolutionY; y++)
+			{
+				for (uint32_t x = 0; x < config.resolutionX; x++)
+				{
+					// Pixels committed after the epoch switch are left out, their splats are not in the drained film yet
+					size_t const idx = x + static_cast<size_t>(y) * config.resolutionX;
+					uint32_t const samples = sampleCounts[idx].load(std::memory_order_acquire);
+					bool const isSettled = samples > 0 && (!bufferSplats || commitEpochs[idx].load(std::memory_order_relaxed) <= drainedEpoch);
+					checkpoint.sampleCounts[idx] = isSettled ? samples : 0;
+					checkpoint.pixels[idx] = isSettled ? image.load(x, y) : glm::vec3(0.0F);
+					if (film != nullptr) {
+						checkpoint.film[idx] = film->get(x, y);
+					}
+				}
+			}
+		});
+	}
 
 	// Render frame
 	printf("Starting render...\n");	
-	#pragma omp parallel for schedule(dynamic)
+	auto const renderStart = std::chrono::high_resolution_clock::now();
+	std::vector<RenderCounters> workerCounters(static_cast<size_t>(omp_get_max_threads()));
+	TileScheduler scheduler(tiles.size(), placement.topology.nodeCount());
+	#pragma omp parallel
+	{
+		// Place worker on its node & use the node-local integrator if available
+		uint32_t const worker = static_cast<uint32_t>(omp_get_thread_num());
+		uint32_t const node = placement.topology.workerNode(worker);
+		std::unique_ptr<ScopedThreadAffinity> const affinity = pinWorker(placement.topology, worker, placement.pinThreads);
+		Integrator const& nodeIntegrator = placement.integratorReplicas.empty() ? integrator : *placement.integratorReplicas[node];
+		RenderCounters counters{}; //< stored per worker after rendering, avoids false sharing between workers
+
+		// Buffer splats while checkpointing, so light paths of a pixel reach the film together with its sample count
+		SplatBuffer splatBuffer{};
+		TraceContext workerContext = context;
+		if (bufferSplats) {
+			workerContext.film = &splatBuffer;
+		}
+
+		size_t i = 0;
+		while (scheduler.next(node, i))
+		{
+			Tile const& tile = tiles[i];
+			for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+			{
+				for (uint32_t x = tile.x; x < tile.x + tile.width; x++)
+				{
+					// Skip pixels restored from a checkpoint
+					size_t const idx = x + static_cast<size_t>(y) * config.resolutionX;
+					if (sampleCounts[idx].load(std::memory_order_relaxed) == config.sampleCount) {
+						continue;
+					}
+
+					image.store(x, y, renderPixel(config, view, nodeIntegrator, workerContext, x, y, 0, counters));
+					if (bufferSplats)
+					{
+						std::shared_lock<std::shared_mutex> const lock(commitMutex);
+						splatBuffer.commit(*epochFilms[epoch % 2]);
+						epochLightPathCounts[epoch % 2].fetch_add(config.sampleCount, std::memory_order_relaxed);
+						commitEpochs[idx].store(epoch, std::memory_order_relaxed);
+					}
+					else if (film != nullptr) {
+						lightPathCount.fetch_add(config.sampleCount, std::memory_order_relaxed);
+					}
+
+					sampleCounts[idx].store(config.sampleCount, std::memory_order_release);
+				}
+			}
+		}
+
+		workerCounters[worker] = counters;
+	}
+
+	if (checkpointWriter != nullptr)
+	{
+		checkpointWriter->stop();
+		printf("Wrote %u checkpoints to %s\n", checkpointWriter->writeCount(), config.checkpointPath.c_str());
+	}
+
+	// Drain splats of epochs no snapshot has drained yet
+	if (bufferSplats)
+	{
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			film->accumulate(*epochFilms[i]);
+			lightPathCount.fetch_add(epochLightPathCounts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+	}
+
+	// Resolve splatted contributions, normalized by the number of traced light paths.
+	// Without resuming each camera sample traced one light path, so this equals dividing by the sample count.
+	if (film != nullptr && lightPathCount.load(std::memory_order_relaxed) > 0)
+	{
+		float const filmScale = static_cast<float>(static_cast<double>(pixelCount) / static_cast<double>(lightPathCount.load(std::memory_order_relaxed)));
+		for (uint32_t y = 0; y < config.resolutionY; y++)
+		{
+			for (uint32_t x = 0; x < config.resolutionX; x++) {
+				image.store(x, y, image.load(x, y) + film->get(x, y) * filmScale);
+			}
+		}
+	}
+
+	auto const renderEnd = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> const renderTime = renderEnd - renderStart;
+	RenderCounters counters{};
+	for (RenderCounters const& worker : workerCounters) {
+		counters += worker;
+	}
+
+	printStatistics(config, renderTime.count(), counters, pixelCount - restoredCount);
+
+	// Write out image
+	std::vector<uint32_t> bytes(static_cast<size_t>(config.resolutionX) * config.resolutionY);
 	for (uint32_t y = 0; y < config.resolutionY; y++)
 	{
-		for (uint32_t x = 0; x < config.resolutionX; x++)
+		for (uint32_t x = 0; x < config.resolutionX; x++) {
+			bytes[x + static_cast<size_t>(y) * config.resolutionX] = packPixelRGBA8(image.load(x, y));
+		}
+	}
+
+	if (stbi_write_png(config.filename.c_str(), config.resolutionX, config.resolutionY, 4, bytes.data(), sizeof(uint32_t) * config.resolutionX) == 0) {
+		printf("Failed to write %s\n", config.filename.c_str());
+		return;
+	}
+
+	// Render is complete, remove the checkpoint so later resumes do not pick up a finished render
+	if (!config.checkpointPath.empty()) {
+		remove(config.checkpointPath.c_str());
+	}
+}
+
+void Renderer::renderStreaming(RendererConfig const& config, Camera const& camera, Integrator const& integrator, WorkerPlacement const& placement)
+{
+	ViewPyramid const view = camera.generateViewPyramid();
+	std::vector<Tile> const tiles = generateTiles(config);
+
+	TraceContext context{};
+	context.camera = &camera;
+
+	// Write binary PPM header, pixel rows follow at fixed offsets so tiles can be written in any order
+	FILE* file = fopen(config.filename.c_str(), "wb");
+	if (file == nullptr) {
+		printf("Failed to open %s for writing\n", config.filename.c_str());
+		return;
+	}
+
+	int const headerSize = fprintf(file, "P6\n%u %u\n255\n", config.resolutionX, config.resolutionY);
+	if (headerSize < 0) {
+		printf("Failed to write %s header\n", config.filename.c_str());
+		fclose(file);
+		return;
+	}
+
+	uint32_t const tileSize = glm::max(config.tileSize, 1U);
+	size_t const tilePixels = static_cast<size_t>(tileSize) * tileSize;
+	size_t const tileMemory = Framebuffer(tileSize, tileSize, config.halfPrecision).memoryUsage() + tilePixels * 3;
+	printf("Streaming render:\n");
+	printf("  Tile count:     %zu\n", tiles.size());
+	printf("  Tile memory:    %.3f KiB x %d threads\n", static_cast<double>(tileMemory) / 1024.0, omp_get_max_threads());
+
+	// Render frame
+	printf("Starting render...\n");
+	auto const renderStart = std::chrono::high_resolution_clock::now();
+	std::mutex fileMutex;
+	bool writeFailed = false;
+	std::vector<RenderCounters> workerCounters(static_cast<size_t>(omp_get_max_threads()));
+	TileScheduler scheduler(tiles.size(), placement.topology.nodeCount());
+	#pragma omp parallel
+	{
+		// Place worker on its node & use the node-local integrator if available
+		uint32_t const worker = static_cast<uint32_t>(omp_get_thread_num());
+		uint32_t const node = placement.topology.workerNode(worker);
+		std::unique_ptr<ScopedThreadAffinity> const affinity = pinWorker(placement.topology, worker, placement.pinThreads);
+		Integrator const& nodeIntegrator = placement.integratorReplicas.empty() ? integrator : *placement.integratorReplicas[node];
+		RenderCounters counters{}; //< stored per worker after rendering, avoids false sharing between workers
+
+		// Per thread tile storage, reused for every tile this thread renders
+		Framebuffer tileBuffer(tileSize, tileSize, config.halfPrecision);
+		std::vector<uint8_t> tileBytes(tilePixels * 3);
+
+		size_t i = 0;
+		while (scheduler.next(node, i))
 		{
-			uint32_t const pixelSeed = (x + y * config.resolutionX) + 0x1234;
-			WhiteNoiseSampler sampler(pixelSeed);
+			Tile const& tile = tiles[i];
+			for (uint32_t y = 0; y < tile.height; y++)
+			{
+				for (uint32_t x = 0; x < tile.width; x++) {
+					tileBuffer.store(x, y, renderPixel(config, view, nodeIntegrator, context, tile.x + x, tile.y + y, 0, counters));
+				}
+			}
 
-			glm::vec3 sample{};
-			for (uint32_t s = 0; s < config.sampleCount; s++)
+			// Finalize tile to RGB8
+			for (uint32_t y = 0; y < tile.height; y++)
 			{
-				// Get pixel as floats
-				float const px = static_cast<float>(x);
-				float const py = static_cast<float>(y);
-
-				// Calculate pixel UV w/ jitter for anti aliasing
-				glm::vec2 const jitter = sampler.sample2D(); //< samples in range [0, 1]
-				float const u = (px + jitter.x) / static_cast<float>(config.resolutionX);
-				float const v = (py + jitter.y) / static_cast<float>(config.resolutionY);
-
-				// Set up ray
-				glm::vec3 const viewPosition = view.pxTopLeft + u * (view.pxTopRight - view.pxTopLeft) + v * (view.pxBottomLeft - view.pxTopLeft);
-				glm::vec3 const origin = view.origin;
-				glm::vec3 const direction = glm::normalize(viewPosition - origin);
-				Ray const primary(origin, direction);
-
-				// Sample scene integrator
-				sample += integrator.trace(primary, sampler);
+				for (uint32_t x = 0; x < tile.width; x++)
+				{
+					uint32_t const rgba = packPixelRGBA8(tileBuffer.load(x, y));
+					size_t const idx = (x + static_cast<size_t>(y) * tile.width) * 3;
+					tileBytes[idx + 0] = static_cast<uint8_t>(rgba & 0xFF);
+					tileBytes[idx + 1] = static_cast<uint8_t>((rgba >> 8) & 0xFF);
+					tileBytes[idx + 2] = static_cast<uint8_t>((rgba >> 16) & 0xFF);
+				}
 			}
 
-			sample /= static_cast<float>(config.sampleCount);
-			image[x + y * config.resolutionX] = { sample, 1.0F };
+			// Write tile rows to their image offsets
+			std::lock_guard<std::mutex> lock(fileMutex);
+			for (uint32_t y = 0; y < tile.height; y++)
+			{
+				uint64_t const offset = static_cast<uint64_t>(headerSize) + ((static_cast<uint64_t>(tile.y + y) * config.resolutionX) + tile.x) * 3;
+				size_t const rowSize = static_cast<size_t>(tile.width) * 3;
+				if (seekFile(file, offset) != 0 || fwrite(&tileBytes[static_cast<size_t>(y) * rowSize], 1, rowSize, file) != rowSize) {
+					writeFailed = true;
+				}
+			}
 		}
+
+		workerCounters[worker] = counters;
 	}
-	printf("Completed render\n");
 
-	// Write out image
-	std::vector<uint32_t> bytes(config.resolutionX * config.resolutionY);
-	for (size_t i = 0; i < image.size(); i++)
+	fclose(file);
+	if (writeFailed) {
+		printf("Failed to write tiles to %s\n", config.filename.c_str());
+	}
+
+	auto const renderEnd = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> const renderTime = renderEnd - renderStart;
+	RenderCounters counters{};
+	for (RenderCounters const& worker : workerCounters) {
+		counters += worker;
+	}
+
+	printStatistics(config, renderTime.count(), counters, static_cast<size_t>(config.resolutionX) * config.resolutionY);
+}
+
+void Renderer::fillRadianceCache(RendererConfig const& config, Camera const& camera, Integrator const& integrator, WorkerPlacement const& placement)
+{
+	ViewPyramid const view = camera.generateViewPyramid();
+	std::vector<Tile> const tiles = generateTiles(config);
+
+	RendererConfig fillConfig = config;
+	fillConfig.sampleCount = config.cacheFillSamples;
+
+	TraceContext context{};
+	context.camera = &camera;
+	context.fillRadianceCache = true;
+
+	// Fill samples use a different seed than render samples, avoiding correlation between cache & render
+	uint32_t const seedOffset = 0x9E3779B9;
+
+	auto const fillStart = std::chrono::high_resolution_clock::now();
+	TileScheduler scheduler(tiles.size(), placement.topology.nodeCount());
+	#pragma omp parallel
+	{
+		uint32_t const worker = static_cast<uint32_t>(omp_get_thread_num());
+		uint32_t const node = placement.topology.workerNode(worker);
+		std::unique_ptr<ScopedThreadAffinity> const affinity = pinWorker(placement.topology, worker, placement.pinThreads);
+		Integrator const& nodeIntegrator = placement.integratorReplicas.empty() ? integrator : *placement.integratorReplicas[node];
+		RenderCounters counters{};
+
+		size_t i = 0;
+		while (scheduler.next(node, i))
+		{
+			Tile const& tile = tiles[i];
+			for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+			{
+				for (uint32_t x = tile.x; x < tile.x + tile.width; x++) {
+					renderPixel(fillConfig, view, nodeIntegrator, context, x, y, seedOffset, counters);
+				}
+			}
+		}
+	}
+
+	auto const fillEnd = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> const fillTime = fillEnd - fillStart;
+	printf("Filled radiance cache in %.3f s (%u samples per pixel)\n", fillTime.count(), config.cacheFillSamples);
+}
+
+Renderer::WorkerPlacement Renderer::createWorkerPlacement(RendererConfig const& config, Integrator const& integrator)
+{
+	WorkerPlacement placement{};
+	if (!config.numaAware) {
+		return placement;
+	}
+
+	placement.topology = NumaTopology::detect();
+	placement.pinThreads = true;
+
+	printf("NUMA topology:\n");
+	for (uint32_t node = 0; node < placement.topology.nodeCount(); node++) {
+		printf("  Node %u:         %zu CPUs\n", placement.topology.node(node).id, placement.topology.node(node).cpus.size());
+	}
+
+	Scene const* scene = integrator.getSceneData();
+	if (!config.numaReplication || scene == nullptr || placement.topology.nodeCount() < 2) {
+		return placement;
+	}
+
+	// Copy scene & rebuild acceleration structures on a thread pinned to each node, first touch places the replica in node-local memory.
+	// The radiance cache is not replicated, all nodes read from the one instance shared by the integrator clones.
+	auto const replicationStart = std::chrono::high_resolution_clock::now();
+	for (uint32_t node = 0; node < placement.topology.nodeCount(); node++)
+	{
+		placement.topology.runOnNode(node, [&]() {
+			std::unique_ptr<Scene> sceneReplica = std::make_unique<Scene>(*scene);
+			std::unique_ptr<Integrator> integratorReplica = integrator.clone();
+			integratorReplica->setSceneData(*sceneReplica);
+
+			placement.sceneReplicas.push_back(std::move(sceneReplica));
+			placement.integratorReplicas.push_back(std::move(integratorReplica));
+		});
+	}
+
+	auto const replicationEnd = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> const replicationTime = replicationEnd - replicationStart;
+	printf("Replicated scene data to %u nodes in %.3f s\n", placement.topology.nodeCount(), replicationTime.count());
+
+	return placement;
+}
+
+std::vector<Tile> Renderer::generateTiles(RendererConfig const& config)
+{
+	uint32_t const tileSize = glm::max(config.tileSize, 1U);
+	std::vector<Tile> tiles{};
+	for (uint32_t y = 0; y < config.resolutionY; y += tileSize)
 	{
-		// Do gamma conversion
-		glm::vec4 const& pixel = image[i];
-		glm::vec4 const gamma = glm::vec4(glm::pow(glm::vec3(pixel), glm::vec3(1.0F / 2.2F)), pixel.a);
+		for (uint32_t x = 0; x < config.resolutionX; x += tileSize) {
+			tiles.push_back(Tile{ x, y, glm::min(tileSize, config.resolutionX - x), glm::min(tileSize, config.resolutionY - y) });
+		}
+	}
+
+	return tiles;
+}
+
+glm::vec3 Renderer::renderPixel(RendererConfig const& config, ViewPyramid const& view, Integrator const& integrator, TraceContext const& context, uint32_t x, uint32_t y, uint32_t seedOffset, RenderCounters& counters)
+{
+	uint32_t const pixelSeed = (x + y * config.resolutionX) + PixelSeedBase + seedOffset;
+	WhiteNoiseSampler sampler(pixelSeed);
+
+	// Per pixel context, tracks the running pixel estimate for adjoint-driven path termination
+	TraceContext pixelContext = context;
+	pixelContext.counters = &counters;
 
-		// Do byte packing
-		uint32_t const r = static_cast<uint32_t>(glm::clamp(gamma.r, 0.0F, 1.0F) * 255.99F) & 0xFF;
-		uint32_t const g = static_cast<uint32_t>(glm::clamp(gamma.g, 0.0F, 1.0F) * 255.99F) & 0xFF;
-		uint32_t const b = static_cast<uint32_t>(glm::clamp(gamma.b, 0.0F, 1.0F) * 255.99F) & 0xFF;
-		uint32_t const a = static_cast<uint32_t>(glm::clamp(gamma.a, 0.0F, 1.0F) * 255.99F) & 0xFF;
-		bytes[i] = (a << 24) + (b << 16) + (g << 8) + r;
+	glm::vec3 sample{};
+	for (uint32_t s = 0; s < config.sampleCount; s++)
+	{
+		// Get pixel as floats
+		float const px = static_cast<float>(x);
+		float const py = static_cast<float>(y);
+
+		// Calculate pixel UV w/ jitter for anti aliasing
+		glm::vec2 const jitter = sampler.sample2D(); //< samples in range [0, 1]
+		float const u = (px + jitter.x) / static_cast<float>(config.resolutionX);
+		float const v = (py + jitter.y) / static_cast<float>(config.resolutionY);
+
+		// Set up ray
+		glm::vec3 const viewPosition = view.pxTopLeft + u * (view.pxTopRight - view.pxTopLeft) + v * (view.pxBottomLeft - view.pxTopLeft);
+		glm::vec3 const origin = view.origin;
+		glm::vec3 const direction = glm::normalize(viewPosition - origin);
+		Ray const primary(origin, direction);
+
+		// Sample scene integrator
+		pixelContext.pixelEstimate = (s > 0) ? sample / static_cast<float>(s) : glm::vec3(0.0F);
+		sample += integrator.trace(primary, sampler, pixelContext);
 	}
 
-	stbi_write_png(config.filename.c_str(), config.resolutionX, config.resolutionY, 4, bytes.data(), sizeof(uint32_t) * config.resolutionX);
+	return sample / static_cast<float>(config.sampleCount);
+}
+
+void Renderer::printStatistics(RendererConfig const& config, double renderTime, RenderCounters const& counters, size_t renderedPixelCount)
+{
+	double const pixelCount = static_cast<double>(renderedPixelCount);
+	printf("Completed render in %.3f s\n", renderTime);
+	printf("  Worker threads: %d\n", omp_get_max_threads());
+	printf("  Samples per second: %.3f M\n", pixelCount * static_cast<double>(config.sampleCount) / renderTime * 1e-6);
+	if (counters.rayCount > 0)
+	{
+		printf("  Rays per pixel: %.2f\n", static_cast<double>(counters.rayCount) / pixelCount);
+		printf("  Rays per second: %.3f M\n", static_cast<double>(counters.rayCount) / renderTime * 1e-6);
+	}
+
+	if (counters.cacheQueryCount > 0) {
+		printf("  Cache hit rate: %.2f %% (%llu queries)\n", 100.0 * static_cast<double>(counters.cacheHitCount) / static_cast<double>(counters.cacheQueryCount), static_cast<unsigned long long>(counters.cacheQueryCount));
+	}
 }
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "camera.hpp"
+#include "framebuffer.hpp"
 #include "integrator.hpp"
+#include "numa.hpp"
 
 /// @brief Renderer configuration data.
 struct RendererConfig
@@ -13,6 +18,50 @@ struct RendererConfig
 	uint32_t resolutionX;
 	uint32_t resolutionY;
 	uint32_t sampleCount;
+	uint32_t tileSize		= 64;
+	bool streaming			= false;	//< write finished tiles directly to a binary PPM file, bounding memory by tiles in flight
+	bool halfPrecision		= false;	//< store pixel data as half floats
+	bool numaAware			= false;	//< pin workers to NUMA nodes & prefer tiles owned by the worker node
+	bool numaReplication	= true;		//< replicate scene & acceleration structures into node-local memory, only used when NUMA aware
+	uint32_t cacheFillSamples	= 0;	//< samples per pixel of the radiance cache fill pass before rendering, 0 to skip
+	std::string checkpointPath;			//< file for periodic render checkpoints, empty to disable checkpointing
+	double checkpointInterval	= 60.0;	//< seconds between checkpoints
+	bool resume					= false;	//< continue from the checkpoint file if it matches the render configuration
+	uint64_t sceneFingerprint	= 0;		//< identifies the scene & integrator settings, checkpoints only resume with a matching fingerprint
+};
+
+/// @brief Rectangular image region rendered as a single work item.
+struct Tile
+{
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+};
+
+/// @brief The TileScheduler hands out tiles to render workers.
+/// Each NUMA node owns a contiguous range of tiles, workers steal from other nodes once their node range is exhausted.
+class TileScheduler
+{
+public:
+	TileScheduler(size_t tileCount, uint32_t nodeCount);
+
+	/// @brief Get the next tile to render for a worker.
+	/// @param node Node index of the worker.
+	/// @param tile Output parameter containing the tile index.
+	/// @return false if all tiles have been handed out.
+	bool next(uint32_t node, size_t& tile);
+
+private:
+	struct TileRange
+	{
+		std::atomic<size_t>	next;
+		size_t				end;
+	};
+
+private:
+	std::unique_ptr<TileRange[]>	m_ranges	= {};
+	uint32_t						m_nodeCount	= 0;
 };
 
 /// @brief The Renderer class allows the rendering of scenes using different integration strategies.
@@ -24,4 +73,46 @@ public:
 	/// @param camera Camera to use for rendering.
 	/// @param integrator Integrator with associated scene to use for rendering.
 	void render(RendererConfig const& config, Camera const& camera, Integrator const& integrator);
+
+private:
+	/// @brief Placement of render workers on NUMA nodes, with optional node-local integrator replicas.
+	struct WorkerPlacement
+	{
+		NumaTopology								topology			= NumaTopology::singleNode();
+		bool										pinThreads			= false;
+		std::vector<std::unique_ptr<Scene>>			sceneReplicas		= {};
+		std::vector<std::unique_ptr<Integrator>>	integratorReplicas	= {}; //< one per node, empty if workers share the source integrator
+	};
+
+private:
+	/// @brief Render into an in-memory framebuffer & write a PNG when done.
+	/// Finished pixels are checkpointed periodically if a checkpoint path is set, & restored from the checkpoint when resuming.
+	void renderFramebuffer(RendererConfig const& config, Camera const& camera, Integrator const& integrator, WorkerPlacement const& placement);
+
+	/// @brief Render tiles & write them to the output file as they complete.
+	void renderStreaming(RendererConfig const& config, Camera const& camera, Integrator const& integrator, WorkerPlacement const& placement);
+
+	/// @brief Trace a low sample count pass filling the integrator radiance cache, results are discarded.
+	void fillRadianceCache(RendererConfig const& config, Camera const& camera, Integrator const& integrator, WorkerPlacement const& placement);
+
+	/// @brief Detect the NUMA topology & build node-local integrator replicas if requested.
+	/// @param config 
+	/// @param integrator Source integrator, replicas copy its settings & scene data.
+	/// @return 
+	static WorkerPlacement createWorkerPlacement(RendererConfig const& config, Integrator const& integrator);
+
+	/// @brief Split an image into tiles, edge tiles are clipped to the image size.
+	/// @param config 
+	/// @return 
+	static std::vector<Tile> generateTiles(RendererConfig const& config);
+
+	/// @brief Render a single pixel by averaging integrator samples.
+	/// @param seedOffset Offset of the pixel sampler seed, decorrelates passes rendering the same pixels.
+	/// @param counters Incremented by the work traced for the pixel.
+	/// @return The averaged pixel value.
+	static glm::vec3 renderPixel(RendererConfig const& config, ViewPyramid const& view, Integrator const& integrator, TraceContext const& context, uint32_t x, uint32_t y, uint32_t seedOffset, RenderCounters& counters);
+
+	/// @brief Print render time, ray & radiance cache statistics.
+	/// @param renderedPixelCount Pixels rendered in this run, excluding pixels restored from a checkpoint.
+	static void printStatistics(RendererConfig const& config, double renderTime, RenderCounters const& counters, size_t renderedPixelCount);
 };
@@ -3,8 +3,10 @@
 #include <string>
 #include <vector>
 
+#include "environment.hpp"
 #include "material.hpp"
 #include "mesh.hpp"
+#include "primitive.hpp"
 
 struct SceneObject
 {
@@ -25,4 +27,6 @@ public:
 	std::vector<Mesh>			meshes		= {};
 	std::vector<Material>		materials	= {};
 	std::vector<SceneObject>	objects		= {};
+	std::vector<AnalyticPrimitive>	primitives	= {}; //< shapes intersected in closed form, not referenced by objects
+	Environment					environment	= Environment::fromColor({ 0.3F, 0.6F, 0.9F }); //< just some blue color by default
 };
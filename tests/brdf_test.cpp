@@ -0,0 +1,89 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "brdf.hpp"
+
+/// @brief Check that BRDF sampling & BRDF evaluation estimate the same reflected energy for a set of fixed materials.
+/// The mean of sampleDisneyBRDF weights is compared against evaluateDisneyBRDF integrated by uniform hemisphere sampling.
+/// @return true if all estimates agree within 4 standard errors.
+static bool checkBRDF()
+{
+	struct BRDFCase
+	{
+		char const*	name;
+		glm::vec3	baseColor;
+		float		metallic;
+		float		roughness;
+	};
+
+	BRDFCase const cases[] = {
+		{ "Diffuse",		{ 0.8F, 0.8F, 0.8F }, 0.0F, 1.0F },
+		{ "Plastic",		{ 0.2F, 0.4F, 0.8F }, 0.0F, 0.5F },
+		{ "Rough metal",	{ 0.9F, 0.6F, 0.3F }, 1.0F, 0.6F },
+		{ "Mixed",			{ 0.5F, 0.5F, 0.5F }, 0.5F, 0.4F },
+	};
+
+	uint32_t const sampleCount = 1U << 20;
+	glm::vec3 const n(0.0F, 0.0F, 1.0F);
+	glm::vec3 const wi = glm::normalize(glm::vec3(0.4F, 0.0F, 0.8F));
+
+	bool passed = true;
+	printf("BRDF check (%u samples per estimator):\n", sampleCount);
+	for (BRDFCase const& test : cases)
+	{
+		Material material{};
+		material.baseColor = test.baseColor;
+		material.metallic = test.metallic;
+		material.roughness = test.roughness;
+
+		// Sampled estimator, weights are BRDF * cosine / PDF
+		WhiteNoiseSampler sampledSampler(0x1234);
+		double sampledSum = 0.0;
+		double sampledSumSq = 0.0;
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			glm::vec3 wo{};
+			float pdf = 0.0F;
+			double const value = luma(sampleDisneyBRDF(sampledSampler, material, wi, n, wo, pdf));
+			sampledSum += value;
+			sampledSumSq += value * value;
+		}
+
+		// Evaluated estimator, BRDF * cosine integrated using uniform hemisphere directions
+		WhiteNoiseSampler uniformSampler(0x5678);
+		double uniformSum = 0.0;
+		double uniformSumSq = 0.0;
+		for (uint32_t i = 0; i < sampleCount; i++)
+		{
+			glm::vec2 const eta = uniformSampler.sample2D();
+			float const z = eta.x;
+			float const r = glm::sqrt(glm::max(0.0F, 1.0F - z * z));
+			float const phi = 2.0F * 3.14159265358979F * eta.y;
+			glm::vec3 const wo(r * glm::cos(phi), r * glm::sin(phi), z);
+
+			float pdf = 0.0F;
+			double const value = luma(evaluateDisneyBRDF(material, wi, n, wo, pdf)) * 2.0 * 3.14159265358979;
+			uniformSum += value;
+			uniformSumSq += value * value;
+		}
+
+		double const count = static_cast<double>(sampleCount);
+		double const sampledMean = sampledSum / count;
+		double const uniformMean = uniformSum / count;
+		double const sampledVariance = glm::max(sampledSumSq / count - sampledMean * sampledMean, 0.0) / count;
+		double const uniformVariance = glm::max(uniformSumSq / count - uniformMean * uniformMean, 0.0) / count;
+		double const tolerance = 4.0 * std::sqrt(sampledVariance + uniformVariance) + 1e-6;
+		bool const agrees = std::abs(sampledMean - uniformMean) <= tolerance;
+		passed = passed && agrees;
+
+		printf("  %-12s sampled %.5f, evaluated %.5f (tolerance %.5f) %s\n", test.name, sampledMean, uniformMean, tolerance, agrees ? "ok" : "MISMATCH");
+	}
+
+	return passed;
+}
+
+int main()
+{
+	return checkBRDF() ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "pathtracer.hpp"
+
+/// @brief Compare batched ray queries against single ray queries for the primary rays of a frame.
+/// The batch API is a convenience interface, it traverses rays one at a time & only amortizes ray conversion
+/// and virtual dispatch, so throughput is expected to match single ray queries.
+int main(int argc, char** argv)
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	char const* scenePath = "./assets/CornellBox.obj";
+	bool useBidirectional = false;
+	uint32_t resolution = 512;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+			scenePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) {
+			resolution = static_cast<uint32_t>(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--integrator") == 0 && i + 1 < argc)
+		{
+			char const* mode = argv[++i];
+			if (strcmp(mode, "bdpt") != 0 && strcmp(mode, "pt") != 0)
+			{
+				printf("Unknown integrator %s, expected pt|bdpt\n", mode);
+				return 1;
+			}
+
+			useBidirectional = strcmp(mode, "bdpt") == 0;
+		}
+		else
+		{
+			printf("Usage: %s [--scene <path>] [--resolution <pixels>] [--integrator pt|bdpt]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (resolution == 0)
+	{
+		printf("Resolution must be positive\n");
+		return 1;
+	}
+
+	// Same camera as the PathTracer executable
+	Camera camera{};
+	camera.FOVy = 60.0F;
+	camera.aspectRatio = 1.0F;
+	camera.position = { 0.0F, 1.0F, 3.0F };
+	camera.forward = { 0.0F, 0.0F, -1.0F };
+
+	Scene const scene = Scene::fromFile(scenePath);
+	std::unique_ptr<Integrator> integrator{};
+	if (useBidirectional) {
+		integrator = std::make_unique<BidirectionalIntegrator>(10 /* max bounce depth */);
+	}
+	else {
+		integrator = std::make_unique<PathTracedIntegrator>(10 /* max bounce depth */);
+	}
+	integrator->setSceneData(scene);
+
+	// Generate pixel center primary rays
+	ViewPyramid const view = camera.generateViewPyramid();
+	std::vector<Ray> rays{};
+	rays.reserve(static_cast<size_t>(resolution) * resolution);
+	for (uint32_t y = 0; y < resolution; y++)
+	{
+		for (uint32_t x = 0; x < resolution; x++)
+		{
+			float const u = (static_cast<float>(x) + 0.5F) / static_cast<float>(resolution);
+			float const v = (static_cast<float>(y) + 0.5F) / static_cast<float>(resolution);
+			glm::vec3 const viewPosition = view.pxTopLeft + u * (view.pxTopRight - view.pxTopLeft) + v * (view.pxBottomLeft - view.pxTopLeft);
+			rays.emplace_back(view.origin, glm::normalize(viewPosition - view.origin));
+		}
+	}
+
+	SplatFilm film(resolution, resolution);
+	TraceContext context{};
+	context.camera = &camera;
+	context.film = integrator->usesSplatting() ? &film : nullptr;
+
+	BatchTracer const batch(*integrator);
+	AccelerationStructure const& accel = integrator->getAccelerationStructure();
+	double const rayCount = static_cast<double>(rays.size());
+	auto const printResult = [&](char const* name, Clock::time_point start, Clock::time_point end) {
+		std::chrono::duration<double> const time = end - start;
+		printf("  %-20s %.3f M rays/s\n", name, rayCount / time.count() * 1e-6);
+	};
+
+	printf("Batch benchmark (%zu primary rays, single thread):\n", rays.size());
+
+	// Closest hit queries
+	uint32_t hitCount = 0;
+	auto const singleHitStart = Clock::now();
+	for (Ray const& ray : rays)
+	{
+		tinybvh::Ray query({ ray.O.x, ray.O.y, ray.O.z }, { ray.D.x, ray.D.y, ray.D.z });
+		hitCount += accel.intersect(query) ? 1 : 0;
+	}
+	printResult("Single intersect:", singleHitStart, Clock::now());
+
+	std::vector<HitRecord> hits(rays.size());
+	auto const batchHitStart = Clock::now();
+	batch.intersect(rays.data(), rays.size(), hits.data());
+	printResult("Batch intersect:", batchHitStart, Clock::now());
+
+	// Occlusion queries
+	uint32_t occludedCount = 0;
+	auto const singleOcclusionStart = Clock::now();
+	for (Ray const& ray : rays)
+	{
+		tinybvh::Ray const query({ ray.O.x, ray.O.y, ray.O.z }, { ray.D.x, ray.D.y, ray.D.z });
+		occludedCount += accel.isOccluded(query) ? 1 : 0;
+	}
+	printResult("Single occluded:", singleOcclusionStart, Clock::now());
+
+	std::vector<uint32_t> occlusionBits((rays.size() + 31) / 32);
+	auto const batchOcclusionStart = Clock::now();
+	batch.occluded(rays.data(), nullptr, rays.size(), occlusionBits.data());
+	printResult("Batch occluded:", batchOcclusionStart, Clock::now());
+
+	// Radiance estimates
+	std::vector<glm::vec3> radiance(rays.size());
+	WhiteNoiseSampler singleSampler(0x1234);
+	auto const singleTraceStart = Clock::now();
+	for (size_t i = 0; i < rays.size(); i++) {
+		radiance[i] = integrator->trace(rays[i], singleSampler, context);
+	}
+	printResult("Single trace:", singleTraceStart, Clock::now());
+
+	WhiteNoiseSampler batchSampler(0x1234);
+	auto const batchTraceStart = Clock::now();
+	batch.radiance(rays.data(), rays.size(), batchSampler, context, radiance.data());
+	printResult("Batch radiance:", batchTraceStart, Clock::now());
+
+	printf("  Primary hit rate:    %.2f %%\n", 100.0 * static_cast<double>(hitCount) / rayCount);
+	printf("  Occluded rate:       %.2f %%\n", 100.0 * static_cast<double>(occludedCount) / rayCount);
+	return 0;
+}